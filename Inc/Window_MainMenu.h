@@ -10,6 +10,8 @@ extern "C" {
 // Include user header files
 #include "UserCommon.h"
 #include "bmp_rgb565.h"
+#include "bmp_rgb565_surface.h"
+#include "bmp_rgb565_async.h"
 
 // Callee of this window
 //#include "Window_Templete.h"
@@ -25,6 +27,7 @@ extern "C" {
 #define BMP_Ypos                        50
 #define BMP_WIDTH                       100     /* width must be a multiple of 4 */
 #define BMP_HEIGHT                      100
+#define BMP_BUFFERS                     2       /* 2: double, 3: triple buffering */
 
 /* Exported function macro ---------------------------------------------------*/
 /* Exported types ------------------------------------------------------------*/
@@ -0,0 +1,169 @@
+#ifndef _BMP_PIXFMT_H_
+#define _BMP_PIXFMT_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/* Type */
+typedef enum
+{
+    BMP_PF_RGB565 = 0,
+    BMP_PF_ARGB8888,
+    BMP_PF_RGB888,
+    BMP_PF_L8,
+    BMP_PF_A8,
+    BMP_PF_COUNT
+} BMP_PixFmt;
+
+/* Macro */
+// Format traits. Every format provides:
+//   _BYTES             bytes per pixel
+//   _LOAD(p, i)        pixel i of row p as 0xAARRGGBB
+//   _NATIVE(c)         0xAARRGGBB in the format's own encoding
+//   _PUT(p, i, v)      write a native value as pixel i of row p
+// Kernels are generated from these by the BMP_PF_DEFINE_* macros below, so
+// each format (pair) gets its own loop with the conversions inlined.
+#define BMP_PF_RGB565_BYTES             2
+#define BMP_PF_RGB565_LOAD(_P_, _I_)    BMP_PF_565to8888(((const uint16_t*)(_P_))[_I_])
+#define BMP_PF_RGB565_NATIVE(_C_)       BMP_PF_8888to565(_C_)
+#define BMP_PF_RGB565_PUT(_P_, _I_, _V_) (((uint16_t*)(_P_))[_I_] = (uint16_t)(_V_))
+
+#define BMP_PF_ARGB8888_BYTES           4
+#define BMP_PF_ARGB8888_LOAD(_P_, _I_)  (((const uint32_t*)(_P_))[_I_])
+#define BMP_PF_ARGB8888_NATIVE(_C_)     (_C_)
+#define BMP_PF_ARGB8888_PUT(_P_, _I_, _V_) (((uint32_t*)(_P_))[_I_] = (_V_))
+
+#define BMP_PF_RGB888_BYTES             3       /* B, G, R in memory */
+#define BMP_PF_RGB888_LOAD(_P_, _I_)    (0xFF000000UL | ((uint32_t)(_P_)[3*(_I_)+2] << 16) | ((uint32_t)(_P_)[3*(_I_)+1] << 8) | (_P_)[3*(_I_)])
+#define BMP_PF_RGB888_NATIVE(_C_)       ((_C_) & 0x00FFFFFFUL)
+#define BMP_PF_RGB888_PUT(_P_, _I_, _V_) ((_P_)[3*(_I_)] = (uint8_t)(_V_), (_P_)[3*(_I_)+1] = (uint8_t)((_V_) >> 8), (_P_)[3*(_I_)+2] = (uint8_t)((_V_) >> 16))
+
+#define BMP_PF_L8_BYTES                 1
+#define BMP_PF_L8_LOAD(_P_, _I_)        (0xFF000000UL | (_P_)[_I_] * 0x00010101UL)
+#define BMP_PF_L8_NATIVE(_C_)           BMP_PF_8888toL8(_C_)
+#define BMP_PF_L8_PUT(_P_, _I_, _V_)    ((_P_)[_I_] = (uint8_t)(_V_))
+
+#define BMP_PF_A8_BYTES                 1       /* Alpha only, loads as black */
+#define BMP_PF_A8_LOAD(_P_, _I_)        ((uint32_t)(_P_)[_I_] << 24)
+#define BMP_PF_A8_NATIVE(_C_)           ((_C_) >> 24)
+#define BMP_PF_A8_PUT(_P_, _I_, _V_)    ((_P_)[_I_] = (uint8_t)(_V_))
+
+// Fill "count" pixels with 0xAARRGGBB
+#define BMP_PF_DEFINE_FILL(_F_) \
+static inline void BMP_PF_Fill_##_F_(uint8_t* dst, uint32_t count, uint32_t argb) \
+{ \
+    uint32_t v = BMP_PF_##_F_##_NATIVE(argb); \
+    for (uint32_t i = 0; i < count; i++) \
+        BMP_PF_##_F_##_PUT(dst, i, v); \
+}
+
+// Convert "count" pixels from SRC to DST
+#define BMP_PF_DEFINE_CONVERT(_D_, _S_) \
+static inline void BMP_PF_Convert_##_D_##_##_S_(uint8_t* dst, const uint8_t* src, uint32_t count) \
+{ \
+    for (uint32_t i = 0; i < count; i++) \
+        BMP_PF_##_D_##_PUT(dst, i, BMP_PF_##_D_##_NATIVE(BMP_PF_##_S_##_LOAD(src, i))); \
+}
+
+// Same format: a straight copy
+#define BMP_PF_DEFINE_COPY(_F_) \
+static inline void BMP_PF_Convert_##_F_##_##_F_(uint8_t* dst, const uint8_t* src, uint32_t count) \
+{ \
+    memcpy(dst, src, count * BMP_PF_##_F_##_BYTES); \
+}
+
+// SRC over DST, source alpha scaled by "alpha" (0..255), weight rescaled to 0..256
+#define BMP_PF_DEFINE_BLEND(_D_, _S_) \
+static inline void BMP_PF_Blend_##_D_##_##_S_(uint8_t* dst, const uint8_t* src, uint32_t count, uint32_t alpha) \
+{ \
+    for (uint32_t i = 0; i < count; i++) \
+    { \
+        uint32_t s = BMP_PF_##_S_##_LOAD(src, i); \
+        uint32_t a = ((s >> 24) * (alpha + 1)) >> 8; \
+        if (a == 0) \
+            continue; \
+        a += a >> 7; \
+        BMP_PF_##_D_##_PUT(dst, i, BMP_PF_##_D_##_NATIVE(BMP_PF_Lerp8888(BMP_PF_##_D_##_LOAD(dst, i), s, a))); \
+    } \
+}
+
+
+/* Conversion helpers shared by the traits */
+static inline uint32_t BMP_PF_565to8888(uint16_t c)
+{
+    uint32_t r = (c >> 11) & 0x1F;
+    uint32_t g = (c >>  5) & 0x3F;
+    uint32_t b =  c        & 0x1F;
+    return 0xFF000000UL | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+}
+
+static inline uint16_t BMP_PF_8888to565(uint32_t c)
+{
+    return (uint16_t)(((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F));
+}
+
+static inline uint8_t BMP_PF_8888toL8(uint32_t c)
+{
+    // Rec. 601 luma, weights sum to 256
+    return (uint8_t)((((c >> 16) & 0xFF) * 77 + ((c >> 8) & 0xFF) * 150 + (c & 0xFF) * 29) >> 8);
+}
+
+// Per-channel d + (s - d) * a / 256 on two channels at a time, result opaque
+static inline uint32_t BMP_PF_Lerp8888(uint32_t d, uint32_t s, uint32_t a)
+{
+    uint32_t d_rb = d & 0x00FF00FFUL, d_g = d & 0x0000FF00UL;
+    uint32_t s_rb = s & 0x00FF00FFUL, s_g = s & 0x0000FF00UL;
+    uint32_t rb = (d_rb * (256 - a) + s_rb * a) >> 8;
+    uint32_t g  = (d_g  * (256 - a) + s_g  * a) >> 8;
+    return 0xFF000000UL | (rb & 0x00FF00FFUL) | (g & 0x0000FF00UL);
+}
+
+// Blend two RGB565 colours with a 5-bit weight (0..32) in one multiply per operand:
+// the channels are spread as 0000 0GGG GGG0 0000 RRRR R000 00BB BBB so they cannot carry into each other.
+static inline uint16_t BMP_PF_Lerp565(uint16_t c0, uint16_t c1, uint32_t w)
+{
+    uint32_t a = (c0 | ((uint32_t)c0 << 16)) & 0x07E0F81FUL;
+    uint32_t b = (c1 | ((uint32_t)c1 << 16)) & 0x07E0F81FUL;
+    uint32_t r = ((a * (32 - w) + b * w) >> 5) & 0x07E0F81FUL;
+    return (uint16_t)(r | (r >> 16));
+}
+
+// RGB565 fill, specialised: two pixels per 32-bit store once the row is word aligned
+static inline void BMP_PF_Fill_RGB565(uint8_t* dst, uint32_t count, uint32_t argb)
+{
+    uint16_t  v = BMP_PF_8888to565(argb);
+    uint16_t* p = (uint16_t*)dst;
+
+    if (count > 0 && ((uintptr_t)p & 0x02))
+    {
+        *p++ = v;
+        count--;
+    }
+    uint32_t  v2 = v | ((uint32_t)v << 16);
+    uint32_t* p2 = (uint32_t*)p;
+    for (uint32_t i = count >> 1; i > 0; i--)
+        *p2++ = v2;
+    if (count & 0x01)
+        *(uint16_t*)p2 = v;
+}
+
+BMP_PF_DEFINE_FILL(ARGB8888)
+BMP_PF_DEFINE_FILL(RGB888)
+BMP_PF_DEFINE_FILL(L8)
+BMP_PF_DEFINE_FILL(A8)
+
+BMP_PF_DEFINE_COPY(RGB565)
+BMP_PF_DEFINE_COPY(ARGB8888)
+BMP_PF_DEFINE_COPY(RGB888)
+BMP_PF_DEFINE_COPY(L8)
+BMP_PF_DEFINE_COPY(A8)
+
+/*********************************** Public methods **********************************/
+uint32_t    BMP_PF_Bytes            (BMP_PixFmt fmt);
+void        BMP_PF_Fill             (BMP_PixFmt fmt, uint8_t* dst, int32_t dst_stride, uint32_t width, uint32_t height, uint32_t argb);
+void        BMP_PF_Convert          (BMP_PixFmt dst_fmt, uint8_t* dst, int32_t dst_stride,
+                                     BMP_PixFmt src_fmt, const uint8_t* src, int32_t src_stride, uint32_t width, uint32_t height);
+void        BMP_PF_Blend            (BMP_PixFmt dst_fmt, uint8_t* dst, int32_t dst_stride,
+                                     BMP_PixFmt src_fmt, const uint8_t* src, int32_t src_stride, uint32_t width, uint32_t height, uint8_t alpha);
+
+#endif  // _BMP_PIXFMT_H_
@@ -0,0 +1,31 @@
+#ifndef _BMP_RGB565_AFFINE_H_
+#define _BMP_RGB565_AFFINE_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Macro */
+#define BMP_565_FIX_ONE             0x10000L                        /* 16.16 fixed point */
+#define BMP_565_FIX(_F_)            ((int32_t)((_F_) * BMP_565_FIX_ONE))
+
+/* Type */
+// Source -> destination mapping in 16.16 fixed point:
+//   dst_x = a * src_x + b * src_y + tx
+//   dst_y = c * src_x + d * src_y + ty
+typedef struct
+{
+    int32_t a, b, tx;
+    int32_t c, d, ty;
+} BMP_565_Affine;
+
+typedef enum
+{
+    BMP_565_SAMPLE_NEAREST = 0,
+    BMP_565_SAMPLE_BILINEAR
+} BMP_565_Sample;
+
+/*********************************** Public methods **********************************/
+void        BMP_565_AffineRotate    (BMP_565_Affine* m, float angle, float scale, float src_cx, float src_cy, float dst_cx, float dst_cy);
+int32_t     BMP_565_BlitAffine      (uint8_t* pbmp_Dst, uint8_t* pbmp_Src, const BMP_565_Affine* m, BMP_565_Sample sample);
+
+#endif  // _BMP_RGB565_AFFINE_H_
@@ -0,0 +1,73 @@
+#ifndef _BMP_RGB565_ASYNC_H_
+#define _BMP_RGB565_ASYNC_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+#include "bmp_pixfmt.h"
+
+/* Config */
+#define BMP_565_ASYNC_QUEUE_LEN         16
+//#define BMP_565_ASYNC_SOFTWARE                    /* Host build: DMA2D emulated by a worker thread (pthread) */
+
+/* Macro */
+#define BMP_565_ASYNC_WAIT_FOREVER      0xFFFFFFFFUL
+
+/* Type */
+typedef enum
+{
+    BMP_565_ASYNC_FILL = 0,         // dst = color
+    BMP_565_ASYNC_COPY,             // dst = src, same format
+    BMP_565_ASYNC_CONVERT,          // dst = src, format converted
+    BMP_565_ASYNC_BLEND             // dst = src over bg, src alpha scaled by "alpha"
+} BMP_565_AsyncOp;
+
+// Called from the DMA2D interrupt (or the emulator thread) when transfer "fence" is done
+typedef void (*BMP_565_AsyncCallback)(uint32_t fence, void* arg);
+
+// One DMA2D transfer, described the way the DMA2D takes it: "width" pixels per
+// line, "height" lines, each line starting "*_offset" pixels after the end of
+// the previous one, lines at increasing addresses.
+// "dst_fmt" is RGB565, ARGB8888 or RGB888. The background of a blend has the
+// format of "dst"; bg = NULL blends onto "dst" in place. An A8 source takes
+// its RGB from "color".
+typedef struct
+{
+    uint8_t                 op;             // BMP_565_AsyncOp
+    uint8_t                 dst_fmt;        // BMP_PixFmt
+    uint8_t                 src_fmt;        // BMP_PixFmt
+    uint8_t                 alpha;
+    uint32_t                color;          // 0xAARRGGBB
+    uint8_t*                dst;
+    const uint8_t*          src;
+    const uint8_t*          bg;
+    uint16_t                dst_offset;
+    uint16_t                src_offset;
+    uint16_t                bg_offset;
+    uint16_t                width;
+    uint16_t                height;
+    BMP_565_AsyncCallback   callback;       // NULL = none
+    void*                   arg;
+} BMP_565_AsyncCmd;
+
+/*********************************** Public methods **********************************/
+// Transfers run in submission order. Every submit returns a fence (> 0) that
+// BMP_565_AsyncWait / BMP_565_AsyncIsDone take; 0 means nothing was queued.
+// Memory in flight must not be touched by the CPU, nor memory sharing its cache lines.
+// The BSP_LCD drawing functions drive the DMA2D themselves: call them between
+// BMP_565_AsyncBspAcquire and BMP_565_AsyncBspRelease, from any task.
+int32_t     BMP_565_AsyncInit       (void);
+void        BMP_565_AsyncDeinit     (void);
+uint32_t    BMP_565_AsyncSubmit     (const BMP_565_AsyncCmd* cmd);
+uint8_t     BMP_565_AsyncIsDone     (uint32_t fence);
+int32_t     BMP_565_AsyncWait       (uint32_t fence, uint32_t timeout_ms);
+int32_t     BMP_565_AsyncFlush      (uint32_t timeout_ms);
+int32_t     BMP_565_AsyncBspAcquire (uint32_t timeout_ms);
+void        BMP_565_AsyncBspRelease (void);
+void        BMP_565_AsyncIRQHandler (void);
+
+uint32_t    BMP_565_AsyncFillRGB    (uint8_t* pbmp, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t r, uint8_t g, uint8_t b);
+uint32_t    BMP_565_AsyncCopy       (uint8_t* pbmp_Dst, int32_t x, int32_t y, uint8_t* pbmp_Src);
+uint32_t    BMP_565_AsyncBlend      (uint8_t* pbmp_Dst, int32_t x, int32_t y, BMP_PixFmt src_fmt, const uint8_t* src,
+                                     uint32_t width, uint32_t height, uint8_t alpha, uint32_t color);
+
+#endif  // _BMP_RGB565_ASYNC_H_
@@ -0,0 +1,58 @@
+#ifndef _BMP_RGB565_ATLAS_H_
+#define _BMP_RGB565_ATLAS_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+#include "bmp_rgb565_runs.h"
+
+/* Config */
+#define BMP_565_ATLAS_MAX_SPRITES   128
+
+/* Type */
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} BMP_565_AtlasEntry;
+
+typedef struct
+{
+    uint32_t id;
+    uint16_t index;
+} BMP_565_AtlasKey;
+
+typedef struct
+{
+    uint8_t*            pbmp;           // All sprites live in this single image
+    uint32_t            shelf_y;        // Top of the current shelf
+    uint32_t            shelf_h;        // Height of the current shelf
+    uint32_t            cursor_x;       // Next free column on the current shelf
+    uint32_t            count;
+    uint8_t             use_key;
+    uint16_t            key;            // RGB565 colour key
+    uint32_t            key_rgb;        // Same key as 0xRRGGBB
+    BMP_565_AtlasEntry  entry[BMP_565_ATLAS_MAX_SPRITES];
+    BMP_565_AtlasKey    lookup[BMP_565_ATLAS_MAX_SPRITES];  // Sorted by id
+    BMP_565_RunSprite*  runs[BMP_565_ATLAS_MAX_SPRITES];    // Opaque runs, built on first keyed blit
+} BMP_565_Atlas;
+
+typedef struct
+{
+    uint16_t sprite;                    // Index returned by BMP_565_AtlasAdd()/BMP_565_AtlasFind()
+    int16_t  x;
+    int16_t  y;
+} BMP_565_SpriteInst;
+
+/*********************************** Public methods **********************************/
+int32_t     BMP_565_AtlasCreate     (BMP_565_Atlas* atlas, uint32_t width, uint32_t height);
+void        BMP_565_AtlasFree       (BMP_565_Atlas* atlas);
+int32_t     BMP_565_AtlasAdd        (BMP_565_Atlas* atlas, uint32_t id, uint8_t* pbmp_Src);
+int32_t     BMP_565_AtlasFind       (BMP_565_Atlas* atlas, uint32_t id);
+uint32_t    BMP_565_AtlasNameId     (const char* name);
+int32_t     BMP_565_AtlasGetRect    (BMP_565_Atlas* atlas, uint32_t sprite, BMP_565_Rect* rect);
+void        BMP_565_AtlasSetColorKey(BMP_565_Atlas* atlas, uint8_t enable, uint8_t r, uint8_t g, uint8_t b);
+void        BMP_565_AtlasBlit       (uint8_t* pbmp_Dst, BMP_565_Atlas* atlas, const BMP_565_SpriteInst* inst, uint32_t count);
+
+#endif  // _BMP_RGB565_ATLAS_H_
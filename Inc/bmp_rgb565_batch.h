@@ -0,0 +1,84 @@
+#ifndef _BMP_RGB565_BATCH_H_
+#define _BMP_RGB565_BATCH_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Config */
+#define BMP_565_BATCH_BAND_SHIFT    4       /* Rows per band = 16 */
+#define BMP_565_BATCH_BAND_ROWS     (1UL << BMP_565_BATCH_BAND_SHIFT)
+#define BMP_565_BATCH_MAX_BANDS     32      /* Images up to 512 rows are binned */
+//#define BMP_565_BATCH_PTHREAD                     /* Host build: bands replayed by worker threads */
+#define BMP_565_BATCH_THREADS       4
+
+#ifdef BMP_565_BATCH_PTHREAD
+#include <pthread.h>
+#endif
+
+/* Type */
+// 1bpp font, rows LSB first. Same layout as uGUI's UG_FONT, so "(const BMP_565_Font*)&FONT_8X12" works.
+typedef struct
+{
+    const uint8_t* p;
+    int16_t char_width;
+    int16_t char_height;
+} BMP_565_Font;
+
+typedef enum
+{
+    BMP_565_CMD_FILL = 0,
+    BMP_565_CMD_LINE,
+    BMP_565_CMD_BLIT,
+    BMP_565_CMD_TEXT
+} BMP_565_CmdType;
+
+typedef struct
+{
+    uint8_t  type;
+    uint16_t col;
+    int32_t  x0, y0, x1, y1;        // Fill: rectangle, Line: end points, Blit/Text: destination
+    int32_t  x_min, y_min;          // Bounding box, used for band binning
+    int32_t  x_max, y_max;
+    union
+    {
+        uint8_t*    psrc;           // Blit
+        const char* str;            // Text
+    };
+    const BMP_565_Font* font;       // Text
+} BMP_565_Cmd;
+
+// One command of a band. A line also keeps its Bresenham state at its first
+// row in the band, so the band does not step it from the start.
+typedef struct
+{
+    uint32_t cmd;
+    int32_t  x;                     // Line: x at the first row in the band
+    int32_t  err;                   // Line: error term there
+} BMP_565_CmdBin;
+
+// The bins are built once per list (BMP_565_CmdListBin) as one array of
+// entries grouped by band: band "b" owns bins[bin_start[b]] to bins[bin_start[b + 1] - 1].
+typedef struct
+{
+    BMP_565_Cmd*    cmds;
+    uint32_t        count;
+    uint32_t        max;
+    BMP_565_CmdBin* bins;           // NULL = every band scans the whole list
+    uint32_t        bins_max;
+    uint32_t        bin_height;     // Image height the bins were built for, 0 = not built
+    uint32_t        bin_start[BMP_565_BATCH_MAX_BANDS + 1];
+} BMP_565_CmdList;
+
+/*********************************** Public methods **********************************/
+void        BMP_565_CmdListInit     (BMP_565_CmdList* list, BMP_565_Cmd* buf, uint32_t max, BMP_565_CmdBin* bins, uint32_t bins_max);
+void        BMP_565_CmdListClear    (BMP_565_CmdList* list);
+int32_t     BMP_565_CmdFill         (BMP_565_CmdList* list, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t r, uint8_t g, uint8_t b);
+int32_t     BMP_565_CmdLine         (BMP_565_CmdList* list, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t r, uint8_t g, uint8_t b);
+int32_t     BMP_565_CmdBlit         (BMP_565_CmdList* list, int32_t x, int32_t y, uint8_t* pbmp_Src);
+int32_t     BMP_565_CmdText         (BMP_565_CmdList* list, int32_t x, int32_t y, const char* str, const BMP_565_Font* font, uint8_t r, uint8_t g, uint8_t b);
+uint32_t    BMP_565_CmdListBands    (uint8_t* pbmp);
+int32_t     BMP_565_CmdListBin      (BMP_565_CmdList* list, uint8_t* pbmp);
+void        BMP_565_CmdListExecuteBand(uint8_t* pbmp, const BMP_565_CmdList* list, uint32_t band);
+void        BMP_565_CmdListExecute  (uint8_t* pbmp, BMP_565_CmdList* list);
+
+#endif  // _BMP_RGB565_BATCH_H_
@@ -0,0 +1,15 @@
+#ifndef _BMP_RGB565_DIFF_H_
+#define _BMP_RGB565_DIFF_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Config */
+#define BMP_565_DIFF_TILE           16      /* Tile edge in pixels (changed-region granularity) */
+#define BMP_565_DIFF_MERGE_COST     256     /* Max. unchanged pixels a merge may pull into a rectangle */
+
+/*********************************** Public methods **********************************/
+uint32_t    BMP_565_Diff        (uint8_t* pbmp_A, uint8_t* pbmp_B, BMP_565_Rect* out_rects, uint32_t max);
+uint32_t    BMP_565_DiffEx      (uint8_t* pbmp_A, uint8_t* pbmp_B, BMP_565_Rect* out_rects, uint32_t max, uint32_t merge_cost);
+
+#endif  // _BMP_RGB565_DIFF_H_
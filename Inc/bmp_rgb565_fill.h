@@ -0,0 +1,22 @@
+#ifndef _BMP_RGB565_FILL_H_
+#define _BMP_RGB565_FILL_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Type */
+// Pending span: row "y" between "xl" and "xr" (inclusive) still has to be
+// scanned; it was reached from row y - dy.
+typedef struct
+{
+    int16_t y;
+    int16_t xl;
+    int16_t xr;
+    int16_t dy;
+} BMP_565_FillSpan;
+
+/*********************************** Public methods **********************************/
+int32_t     BMP_565_FloodFillRGB    (uint8_t* pbmp, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b,
+                                     BMP_565_FillSpan* stack, uint32_t stack_size);
+
+#endif  // _BMP_RGB565_FILL_H_
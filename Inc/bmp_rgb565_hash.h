@@ -0,0 +1,22 @@
+#ifndef _BMP_RGB565_HASH_H_
+#define _BMP_RGB565_HASH_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Config */
+#define BMP_565_HASH_TILE_SHIFT     4       /* Tile edge = 16 px */
+#define BMP_565_HASH_TILE           (1UL << BMP_565_HASH_TILE_SHIFT)
+#define BMP_565_HASH_SLOTS          4       /* Max. number of images with an attached hash table */
+
+/*********************************** Public methods **********************************/
+int32_t     BMP_565_HashAttach      (uint8_t* pbmp);
+void        BMP_565_HashDetach      (uint8_t* pbmp);
+void        BMP_565_HashInvalidate  (uint8_t* pbmp, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+uint32_t    BMP_565_HashTileCount   (uint8_t* pbmp);
+uint32_t    BMP_565_HashGetTile     (uint8_t* pbmp, uint32_t tile);
+void        BMP_565_HashGetTileRect (uint8_t* pbmp, uint32_t tile, BMP_565_Rect* rect);
+uint32_t    BMP_565_HashSnapshot    (uint8_t* pbmp, uint32_t* snapshot);
+uint32_t    BMP_565_HashDiff        (uint8_t* pbmp, const uint32_t* snapshot, uint32_t* out_tiles, uint32_t max);
+
+#endif  // _BMP_RGB565_HASH_H_
@@ -0,0 +1,48 @@
+#ifndef _BMP_RGB565_LUT_H_
+#define _BMP_RGB565_LUT_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Type */
+// Per-channel tone curve: out = clamp((in ^ (1 / gamma) - 0.5) * contrast + 0.5 + brightness),
+// values normalised to 0..1. {1, 0, 1} is the identity.
+typedef struct
+{
+    float gamma;
+    float brightness;
+    float contrast;
+} BMP_565_LutCurve;
+
+// Contribution of one input channel level to the three outputs, 12.4 fixed point in 0..255 units
+typedef struct
+{
+    int16_t r;
+    int16_t g;
+    int16_t b;
+} BMP_565_LutMix;
+
+typedef enum
+{
+    BMP_565_LUT_CHANNEL = 0,        // Independent curves
+    BMP_565_LUT_MATRIX              // Curves, then a 3x3 matrix
+} BMP_565_LutMode;
+
+typedef struct
+{
+    uint8_t         mode;
+    uint16_t        r[32];          // Channel mode: output bits already in RGB565 position
+    uint16_t        g[64];
+    uint16_t        b[32];
+    BMP_565_LutMix  mix_r[32];      // Matrix mode
+    BMP_565_LutMix  mix_g[64];
+    BMP_565_LutMix  mix_b[32];
+} BMP_565_Lut;
+
+/*********************************** Public methods **********************************/
+void        BMP_565_LutInitCurve    (BMP_565_Lut* lut, const BMP_565_LutCurve* r, const BMP_565_LutCurve* g, const BMP_565_LutCurve* b);
+void        BMP_565_LutInitMatrix   (BMP_565_Lut* lut, const float m[9], const BMP_565_LutCurve* r, const BMP_565_LutCurve* g, const BMP_565_LutCurve* b);
+void        BMP_565_LutApplyRow     (const BMP_565_Lut* lut, uint16_t* dst, const uint16_t* src, uint32_t count);
+void        BMP_565_LutApply        (uint8_t* pbmp, const BMP_565_Lut* lut, const BMP_565_Rect* rect);
+
+#endif  // _BMP_RGB565_LUT_H_
@@ -0,0 +1,27 @@
+#ifndef _BMP_RGB565_MIP_H_
+#define _BMP_RGB565_MIP_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Config */
+#define BMP_565_MIP_MAX_LEVELS      12          /* 2048 x 2048 down to 1 x 1 */
+
+/* Type */
+// Level 0 is the caller's image (not copied). Levels 1 .. levels-1 are each
+// half the size of the previous one and live back-to-back in "block".
+typedef struct
+{
+    uint8_t*    level[BMP_565_MIP_MAX_LEVELS];
+    uint32_t    levels;
+    uint8_t*    block;
+} BMP_565_Mip;
+
+/*********************************** Public methods **********************************/
+int32_t     BMP_565_MipBuild        (BMP_565_Mip* mip, uint8_t* pbmp_Src, uint32_t max_levels);
+void        BMP_565_MipUpdate       (BMP_565_Mip* mip);
+void        BMP_565_MipFree         (BMP_565_Mip* mip);
+uint32_t    BMP_565_MipSelect       (BMP_565_Mip* mip, uint32_t width, uint32_t height);
+void        BMP_565_MipBlitScaled   (uint8_t* pbmp_Dst, BMP_565_Mip* mip, int32_t x, int32_t y, uint32_t width, uint32_t height);
+
+#endif  // _BMP_RGB565_MIP_H_
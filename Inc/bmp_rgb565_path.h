@@ -0,0 +1,84 @@
+#ifndef _BMP_RGB565_PATH_H_
+#define _BMP_RGB565_PATH_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Config */
+#define BMP_565_PATH_MAX_CONTOURS   16
+#define BMP_565_PATH_MAX_ACTIVE     128         /* Edges crossing one scanline */
+#define BMP_565_PATH_MAX_WIDTH      480         /* Widest image drawn with anti-aliasing */
+#define BMP_565_PATH_AA_SHIFT       2           /* 4 sub-scanlines per pixel row */
+#define BMP_565_PATH_TOLERANCE      0.25f       /* Max flattening error, in pixels */
+
+/* Type */
+typedef struct
+{
+    float x;
+    float y;
+} BMP_565_Point;
+
+// Polygon edge, always stored top to bottom (y0 < y1)
+typedef struct
+{
+    float   x0, y0;
+    float   x1, y1;
+    float   dxdy;
+    int32_t dir;                    // +1 / -1 winding
+} BMP_565_Edge;
+
+typedef enum
+{
+    BMP_565_FILL_NONZERO = 0,
+    BMP_565_FILL_EVENODD
+} BMP_565_FillRule;
+
+typedef enum
+{
+    BMP_565_CAP_BUTT = 0,
+    BMP_565_CAP_SQUARE,
+    BMP_565_CAP_ROUND
+} BMP_565_Cap;
+
+typedef enum
+{
+    BMP_565_JOIN_MITER = 0,
+    BMP_565_JOIN_BEVEL,
+    BMP_565_JOIN_ROUND
+} BMP_565_Join;
+
+typedef struct
+{
+    float           width;
+    BMP_565_Cap     cap;
+    BMP_565_Join    join;
+    float           miter_limit;    // Ratio of miter length to half width, 4.0 is typical
+} BMP_565_Stroke;
+
+// Curves are flattened when they are added, so the path only holds polylines.
+// Point and edge storage is supplied by the caller.
+typedef struct
+{
+    BMP_565_Point*  pts;
+    uint32_t        count;
+    uint32_t        max;
+    BMP_565_Edge*   edges;          // Scratch for filling/stroking
+    uint32_t        edge_count;
+    uint32_t        max_edges;
+    uint16_t        contour_end[BMP_565_PATH_MAX_CONTOURS];     // One past the last point
+    uint32_t        contours;
+    uint32_t        closed;         // One bit per contour
+} BMP_565_Path;
+
+/*********************************** Public methods **********************************/
+void        BMP_565_PathInit        (BMP_565_Path* path, BMP_565_Point* pts, uint32_t max_pts, BMP_565_Edge* edges, uint32_t max_edges);
+void        BMP_565_PathClear       (BMP_565_Path* path);
+int32_t     BMP_565_PathMoveTo      (BMP_565_Path* path, float x, float y);
+int32_t     BMP_565_PathLineTo      (BMP_565_Path* path, float x, float y);
+int32_t     BMP_565_PathQuadTo      (BMP_565_Path* path, float cx, float cy, float x, float y);
+int32_t     BMP_565_PathCubicTo     (BMP_565_Path* path, float c1x, float c1y, float c2x, float c2y, float x, float y);
+void        BMP_565_PathClose       (BMP_565_Path* path);
+int32_t     BMP_565_PathFill        (uint8_t* pbmp, BMP_565_Path* path, BMP_565_FillRule rule, uint8_t aa, uint8_t r, uint8_t g, uint8_t b);
+int32_t     BMP_565_PathStroke      (uint8_t* pbmp, BMP_565_Path* path, const BMP_565_Stroke* stroke, uint8_t aa, uint8_t r, uint8_t g, uint8_t b);
+
+#endif  // _BMP_RGB565_PATH_H_
@@ -0,0 +1,31 @@
+#ifndef _BMP_RGB565_RUNS_H_
+#define _BMP_RGB565_RUNS_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Type */
+typedef struct
+{
+    uint16_t x;         // Start column, relative to the sprite
+    uint16_t len;       // Opaque pixels
+} BMP_565_Run;
+
+// Opaque runs of a sprite (or of a sub-rectangle of a larger image), one allocation
+typedef struct
+{
+    uint16_t     src_x;
+    uint16_t     src_y;
+    uint16_t     width;
+    uint16_t     height;
+    uint32_t*    row_start;     // height + 1 entries, index into "runs"
+    BMP_565_Run* runs;
+} BMP_565_RunSprite;
+
+/*********************************** Public methods **********************************/
+BMP_565_RunSprite*  BMP_565_RunsFromKey (uint8_t* pbmp_Src, const BMP_565_Rect* src_rect, uint8_t r, uint8_t g, uint8_t b);
+BMP_565_RunSprite*  BMP_565_RunsFromMask(uint8_t* pbmp_Src, const BMP_565_Rect* src_rect, const uint8_t* mask, uint32_t mask_stride);
+void                BMP_565_RunsFree    (BMP_565_RunSprite* rs);
+void                BMP_565_BlitRuns    (uint8_t* pbmp_Dst, int32_t x, int32_t y, uint8_t* pbmp_Src, const BMP_565_RunSprite* rs);
+
+#endif  // _BMP_RGB565_RUNS_H_
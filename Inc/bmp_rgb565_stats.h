@@ -0,0 +1,32 @@
+#ifndef _BMP_RGB565_STATS_H_
+#define _BMP_RGB565_STATS_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Type */
+// One bin per channel level: R and B 0..31, G 0..63
+typedef struct
+{
+    uint32_t r[32];
+    uint32_t g[64];
+    uint32_t b[32];
+    uint32_t odd[32 + 64 + 32];     // Scratch: second copy for odd pixels
+} BMP_565_Hist;
+
+// Per channel, index 0..2 = R, G, B, in channel levels as above
+typedef struct
+{
+    uint32_t count;
+    uint8_t  min[3];
+    uint8_t  max[3];
+    float    mean[3];
+    float    variance[3];
+} BMP_565_Stats;
+
+/*********************************** Public methods **********************************/
+void        BMP_565_Histogram       (uint8_t* pbmp, const BMP_565_Rect* rect, BMP_565_Hist* hist);
+void        BMP_565_StatsFromHist   (const BMP_565_Hist* hist, BMP_565_Stats* stats);
+void        BMP_565_GetStats        (uint8_t* pbmp, const BMP_565_Rect* rect, BMP_565_Stats* stats, BMP_565_Hist* hist);
+
+#endif  // _BMP_RGB565_STATS_H_
@@ -0,0 +1,70 @@
+#ifndef _BMP_RGB565_SURFACE_H_
+#define _BMP_RGB565_SURFACE_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Config */
+#define BMP_565_SURFACE_MAX_BUF         3
+//#define BMP_565_SURFACE_PTHREAD                   /* Host build: pthread mutex/condition variable instead of FreeRTOS */
+
+#ifdef BMP_565_SURFACE_PTHREAD
+#include <pthread.h>
+#else
+#include "FreeRTOS.h"
+#include "semphr.h"
+#endif
+
+/* Macro */
+#define BMP_565_SURFACE_WAIT_FOREVER    0xFFFFFFFFUL
+
+/* Type */
+#ifdef BMP_565_SURFACE_PTHREAD
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        count;
+    uint32_t        max;
+} BMP_565_Sem;
+#else
+typedef SemaphoreHandle_t BMP_565_Sem;
+#endif
+
+// Two or three images of the same size. The producer draws into the back
+// buffer between BeginFrame and EndFrame; the presenter picks up the newest
+// finished frame with AcquireFront and reports with PresentDone when it has
+// been shown. Frames are numbered from 1; a producer can wait on the number
+// returned by EndFrame (the fence) to know the frame reached the panel.
+// One producer task and one presenter task (which may be the same task).
+typedef struct
+{
+    uint8_t*            buf[BMP_565_SURFACE_MAX_BUF];
+    uint8_t             count;
+    volatile uint8_t    free_mask;      // Buffers available to BeginFrame
+    volatile int8_t     back;           // Being drawn, -1 = none
+    volatile int8_t     ready;          // Finished, not yet acquired, -1 = none
+    volatile int8_t     front;          // Being or last presented
+    volatile uint32_t   seq;            // Number of the last ended frame
+    volatile uint32_t   ready_seq;
+    volatile uint32_t   front_seq;
+    volatile uint32_t   presented_seq;
+    BMP_565_Sem         sem_free;       // Counts free buffers
+    BMP_565_Sem         sem_ready;      // Given when a frame is ended
+    BMP_565_Sem         sem_fence;      // Given when a frame is presented
+#ifdef BMP_565_SURFACE_PTHREAD
+    pthread_mutex_t     lock;
+#endif
+} BMP_565_Surface;
+
+/*********************************** Public methods **********************************/
+int32_t     BMP_565_SurfaceCreate       (BMP_565_Surface* s, uint32_t width, uint32_t height, uint32_t nbuf);
+void        BMP_565_SurfaceFree         (BMP_565_Surface* s);
+uint8_t*    BMP_565_SurfaceBeginFrame   (BMP_565_Surface* s, uint32_t timeout_ms);
+uint32_t    BMP_565_SurfaceEndFrame     (BMP_565_Surface* s);
+uint8_t*    BMP_565_SurfaceAcquireFront (BMP_565_Surface* s, uint32_t timeout_ms);
+uint8_t*    BMP_565_SurfaceGetFront     (BMP_565_Surface* s);
+void        BMP_565_SurfacePresentDone  (BMP_565_Surface* s);
+int32_t     BMP_565_SurfaceWaitFence    (BMP_565_Surface* s, uint32_t seq, uint32_t timeout_ms);
+
+#endif  // _BMP_RGB565_SURFACE_H_
@@ -0,0 +1,50 @@
+#ifndef _BMP_RGB565_TILED_H_
+#define _BMP_RGB565_TILED_H_
+
+#include <stdint.h>
+#include "bmp_rgb565.h"
+
+/* Type */
+typedef enum
+{
+    BMP_565_TILE_8x8 = 0,           // 8x8 tiles, rows inside a tile
+    BMP_565_TILE_16x16,             // 16x16 tiles, rows inside a tile
+    BMP_565_TILE_MORTON16           // 16x16 tiles, Z-order inside a tile
+} BMP_565_TileLayout;
+
+// RGB565 image stored tile by tile (tiles in row-major order, the last tile
+// row/column padded). Any layout maps a pixel to
+//   tile_base(x >> shift, y >> shift) + lx[x & mask] + ly[y & mask]
+// so pixel addressing has no layout branches.
+typedef struct
+{
+    uint16_t*   data;
+    uint16_t    width;
+    uint16_t    height;
+    uint16_t    tiles_x;
+    uint16_t    tiles_y;
+    uint8_t     shift;              // log2 of the tile size
+    uint8_t     layout;
+    uint8_t     lx[16];             // Offset of a column inside its tile
+    uint8_t     ly[16];             // Offset of a row inside its tile
+} BMP_565_Tiled;
+
+/* Macro */
+static inline uint32_t BMP_565_TiledIndex(const BMP_565_Tiled* t, uint32_t x, uint32_t y)
+{
+    uint32_t mask = (1UL << t->shift) - 1;
+    return (((y >> t->shift) * t->tiles_x + (x >> t->shift)) << (t->shift << 1)) + t->lx[x & mask] + t->ly[y & mask];
+}
+
+/*********************************** Public methods **********************************/
+int32_t     BMP_565_TiledCreate     (BMP_565_Tiled* t, uint32_t width, uint32_t height, BMP_565_TileLayout layout);
+void        BMP_565_TiledFree       (BMP_565_Tiled* t);
+int32_t     BMP_565_TiledFromLinear (BMP_565_Tiled* t, uint8_t* pbmp_Src);
+int32_t     BMP_565_TiledToLinear   (uint8_t* pbmp_Dst, const BMP_565_Tiled* t);
+void        BMP_565_TiledFillRect   (BMP_565_Tiled* t, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t r, uint8_t g, uint8_t b);
+void        BMP_565_TiledVLine      (BMP_565_Tiled* t, uint32_t x, uint32_t y0, uint32_t y1, uint8_t r, uint8_t g, uint8_t b);
+void        BMP_565_TiledBlit       (BMP_565_Tiled* dst, int32_t x, int32_t y, const BMP_565_Tiled* src);
+int32_t     BMP_565_TiledRotate90   (BMP_565_Tiled* dst, const BMP_565_Tiled* src, uint8_t clockwise);
+void        BMP_565_TiledScale      (BMP_565_Tiled* dst, const BMP_565_Tiled* src);
+
+#endif  // _BMP_RGB565_TILED_H_
@@ -27,6 +27,31 @@
 //#define  USE_FONT_24X40
 //#define  USE_FONT_32X53
 
+/* Glyph cache: run-length encoded glyphs, so repeated text is drawn as spans */
+#define  USE_GLYPH_CACHE
+#define  GLYPH_CACHE_ENTRIES         48
+#define  GLYPH_CACHE_ENTRY_SIZE      256       /* bytes of runs; glyphs needing more are not cached */
+
+/* Text layout cache of textboxes, buttons and window titles */
+#define  TEXT_LAYOUT_MAX_LINES       4         /* texts with more lines are laid out on every draw */
+
+/* Textboxes keep the text on screen to redraw only changed characters */
+#define  TEXTBOX_SAVED_TEXT_LEN      24        /* longer texts are always fully redrawn */
+
+/* Dirty regions: rectangles are merged when their bounding box costs less */
+/* than drawing them apart, each rectangle counting DIRTY_RECT_COST pixels  */
+#define  DIRTY_MAX_RECTS             8
+#define  DIRTY_RECT_COST             256
+
+/* Nesting depth of UG_ClipPush() */
+#define  CLIP_STACK_DEPTH            4
+
+/* Pixel format of UG_COLOR: set it to the framebuffer format so pixels are stored unconverted */
+#define  UG_COLOR_RGB888             0         /* 0x00RRGGBB */
+#define  UG_COLOR_RGB565             1         /* RRRRRGGGGGGBBBBB */
+#define  UG_COLOR_ARGB8888           2         /* 0xFFRRGGBB, alpha forced on output so plain 0xRRGGBB stays opaque */
+#define  UG_COLOR_FORMAT             UG_COLOR_ARGB8888
+
 /* Specify platform-dependent integer types here */
 
 #define __UG_CONST   const
@@ -43,7 +68,29 @@ typedef int32_t      UG_S32;
 /* -- TYPEDEFS                                                                   -- */
 /* -------------------------------------------------------------------------------- */
 typedef UG_S8                                         UG_RESULT;
+#if UG_COLOR_FORMAT == UG_COLOR_RGB565
+typedef UG_U16                                        UG_COLOR;
+#else
 typedef UG_U32                                        UG_COLOR;
+#endif
+
+/* -------------------------------------------------------------------------------- */
+/* -- COLOR CONVERSION                                                           -- */
+/* -------------------------------------------------------------------------------- */
+/* UG_RGB: 0xRRGGBB to UG_COLOR, folded by the compiler for constants */
+#if UG_COLOR_FORMAT == UG_COLOR_RGB565
+#define UG_RGB(c)                                     ((UG_COLOR)((((c)>>8)&0xF800) | (((c)>>5)&0x07E0) | (((c)>>3)&0x001F)))
+#define UG_COLOR_TO_RGB888(c)                         ((((UG_U32)(c)&0xF800)<<8) | (((UG_U32)(c)&0x07E0)<<5) | (((UG_U32)(c)&0x001F)<<3))
+#define UG_COLOR_TO_ARGB8888(c)                       (0xFF000000 | UG_COLOR_TO_RGB888(c))
+#elif UG_COLOR_FORMAT == UG_COLOR_ARGB8888
+#define UG_RGB(c)                                     ((UG_COLOR)(0xFF000000 | (c)))
+#define UG_COLOR_TO_RGB888(c)                         ((UG_U32)(c) & 0x00FFFFFF)
+#define UG_COLOR_TO_ARGB8888(c)                       (0xFF000000 | (UG_U32)(c))
+#else
+#define UG_RGB(c)                                     ((UG_COLOR)(c))
+#define UG_COLOR_TO_RGB888(c)                         ((UG_U32)(c))
+#define UG_COLOR_TO_ARGB8888(c)                       (0xFF000000 | (UG_U32)(c))
+#endif
 
 /* -------------------------------------------------------------------------------- */
 /* -- FUNCTION RESULTS                                                           -- */
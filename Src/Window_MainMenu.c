@@ -29,7 +29,7 @@ static UG_TEXTBOX   txb_Test;
 static bool needFinalize;  // This flag is used in "WindowControlThread" and "window_callback" function
 
 /* BMP */
-static uint8_t* pBMP;
+static BMP_565_Surface surface;     // Draw into the back buffer while the front one is presented
 
 /* Private function prototypes -----------------------------------------------*/
 static void WindowControlThread(void const *argument);
@@ -171,8 +171,7 @@ void window_callback(UG_MESSAGE* msg)
 static void initialize(void)
 {
 	/* Variables Initialization */
-    pBMP = BMP_565_Create(BMP_WIDTH, BMP_HEIGHT);
-    if (pBMP == NULL)
+    if (BMP_565_SurfaceCreate(&surface, BMP_WIDTH, BMP_HEIGHT, BMP_BUFFERS) != 0)
     {
 #ifdef PRINTF_DEBUG_MDOE
         printf("BMP memory allocation error\r\n");
@@ -196,6 +195,10 @@ static void execute(void)
 /* ---------------------------------------------------------------- */
 static void draw(void)
 {
+    uint8_t* pBMP = BMP_565_SurfaceBeginFrame(&surface, MAINMENU_UPDATE_MS);
+    if (pBMP == NULL)
+        return;
+
     // Gradation
     for (uint32_t x = 0; x < BMP_WIDTH; x++)
     {
@@ -220,8 +223,16 @@ static void draw(void)
     BMP_565_DrawRectRGB(pBMP, BMP_WIDTH/2 - 10, BMP_HEIGHT/2 - 10, BMP_WIDTH/2 + 10, BMP_HEIGHT/2 + 10, 0xFF, 0xFF, 0);
     
     
-    // Display
-    BSP_LCD_DrawBitmap(BMP_Xpos, BMP_Ypos, pBMP);
+    BMP_565_SurfaceEndFrame(&surface);
+
+    // Display the finished frame, never the one being drawn
+    uint8_t* pFront = BMP_565_SurfaceAcquireFront(&surface, 0);
+    if (pFront != NULL && BMP_565_AsyncBspAcquire(MAINMENU_UPDATE_MS) == 0)
+    {
+        BSP_LCD_DrawBitmap(BMP_Xpos, BMP_Ypos, pFront);
+        BMP_565_AsyncBspRelease();
+        BMP_565_SurfacePresentDone(&surface);
+    }
 }
 
 /* ---------------------------------------------------------------- */
@@ -230,7 +241,7 @@ static void draw(void)
 static void finalize(void)
 {
     /* Variables Finalization */
-    BMP_565_Free(pBMP);
+    BMP_565_SurfaceFree(&surface);
 }
 
 /***************************************************************END OF FILE****/
@@ -0,0 +1,114 @@
+#include "bmp_pixfmt.h"
+#include <stdlib.h>
+
+
+typedef void (*Fill_fn)   (uint8_t* dst, uint32_t count, uint32_t argb);
+typedef void (*Convert_fn)(uint8_t* dst, const uint8_t* src, uint32_t count);
+typedef void (*Blend_fn)  (uint8_t* dst, const uint8_t* src, uint32_t count, uint32_t alpha);
+
+/* Kernel instantiations: every format pair gets its own branch-free loop */
+#define DEFINE_BLEND_FROM(_S_) \
+    BMP_PF_DEFINE_BLEND(RGB565,   _S_) \
+    BMP_PF_DEFINE_BLEND(ARGB8888, _S_) \
+    BMP_PF_DEFINE_BLEND(RGB888,   _S_) \
+    BMP_PF_DEFINE_BLEND(L8,       _S_) \
+    BMP_PF_DEFINE_BLEND(A8,       _S_)
+
+// Same-format converts are the memcpy specialisations from the header, these are the cross-format ones
+BMP_PF_DEFINE_CONVERT(ARGB8888, RGB565)
+BMP_PF_DEFINE_CONVERT(RGB888,   RGB565)
+BMP_PF_DEFINE_CONVERT(L8,       RGB565)
+BMP_PF_DEFINE_CONVERT(A8,       RGB565)
+BMP_PF_DEFINE_CONVERT(RGB565,   ARGB8888)
+BMP_PF_DEFINE_CONVERT(RGB888,   ARGB8888)
+BMP_PF_DEFINE_CONVERT(L8,       ARGB8888)
+BMP_PF_DEFINE_CONVERT(A8,       ARGB8888)
+BMP_PF_DEFINE_CONVERT(RGB565,   RGB888)
+BMP_PF_DEFINE_CONVERT(ARGB8888, RGB888)
+BMP_PF_DEFINE_CONVERT(L8,       RGB888)
+BMP_PF_DEFINE_CONVERT(A8,       RGB888)
+BMP_PF_DEFINE_CONVERT(RGB565,   L8)
+BMP_PF_DEFINE_CONVERT(ARGB8888, L8)
+BMP_PF_DEFINE_CONVERT(RGB888,   L8)
+BMP_PF_DEFINE_CONVERT(A8,       L8)
+BMP_PF_DEFINE_CONVERT(RGB565,   A8)
+BMP_PF_DEFINE_CONVERT(ARGB8888, A8)
+BMP_PF_DEFINE_CONVERT(RGB888,   A8)
+BMP_PF_DEFINE_CONVERT(L8,       A8)
+
+DEFINE_BLEND_FROM(RGB565)
+DEFINE_BLEND_FROM(ARGB8888)
+DEFINE_BLEND_FROM(RGB888)
+DEFINE_BLEND_FROM(L8)
+DEFINE_BLEND_FROM(A8)
+
+/* Dispatch tables, indexed [dst][src]. Selection happens once per call, never per pixel. */
+static const Fill_fn FillTable[BMP_PF_COUNT] =
+{
+    BMP_PF_Fill_RGB565, BMP_PF_Fill_ARGB8888, BMP_PF_Fill_RGB888, BMP_PF_Fill_L8, BMP_PF_Fill_A8
+};
+
+static const Convert_fn ConvertTable[BMP_PF_COUNT][BMP_PF_COUNT] =
+{
+    { BMP_PF_Convert_RGB565_RGB565,   BMP_PF_Convert_RGB565_ARGB8888,   BMP_PF_Convert_RGB565_RGB888,   BMP_PF_Convert_RGB565_L8,   BMP_PF_Convert_RGB565_A8   },
+    { BMP_PF_Convert_ARGB8888_RGB565, BMP_PF_Convert_ARGB8888_ARGB8888, BMP_PF_Convert_ARGB8888_RGB888, BMP_PF_Convert_ARGB8888_L8, BMP_PF_Convert_ARGB8888_A8 },
+    { BMP_PF_Convert_RGB888_RGB565,   BMP_PF_Convert_RGB888_ARGB8888,   BMP_PF_Convert_RGB888_RGB888,   BMP_PF_Convert_RGB888_L8,   BMP_PF_Convert_RGB888_A8   },
+    { BMP_PF_Convert_L8_RGB565,       BMP_PF_Convert_L8_ARGB8888,       BMP_PF_Convert_L8_RGB888,       BMP_PF_Convert_L8_L8,       BMP_PF_Convert_L8_A8       },
+    { BMP_PF_Convert_A8_RGB565,       BMP_PF_Convert_A8_ARGB8888,       BMP_PF_Convert_A8_RGB888,       BMP_PF_Convert_A8_L8,       BMP_PF_Convert_A8_A8       }
+};
+
+static const Blend_fn BlendTable[BMP_PF_COUNT][BMP_PF_COUNT] =
+{
+    { BMP_PF_Blend_RGB565_RGB565,     BMP_PF_Blend_RGB565_ARGB8888,     BMP_PF_Blend_RGB565_RGB888,     BMP_PF_Blend_RGB565_L8,     BMP_PF_Blend_RGB565_A8     },
+    { BMP_PF_Blend_ARGB8888_RGB565,   BMP_PF_Blend_ARGB8888_ARGB8888,   BMP_PF_Blend_ARGB8888_RGB888,   BMP_PF_Blend_ARGB8888_L8,   BMP_PF_Blend_ARGB8888_A8   },
+    { BMP_PF_Blend_RGB888_RGB565,     BMP_PF_Blend_RGB888_ARGB8888,     BMP_PF_Blend_RGB888_RGB888,     BMP_PF_Blend_RGB888_L8,     BMP_PF_Blend_RGB888_A8     },
+    { BMP_PF_Blend_L8_RGB565,         BMP_PF_Blend_L8_ARGB8888,         BMP_PF_Blend_L8_RGB888,         BMP_PF_Blend_L8_L8,         BMP_PF_Blend_L8_A8         },
+    { BMP_PF_Blend_A8_RGB565,         BMP_PF_Blend_A8_ARGB8888,         BMP_PF_Blend_A8_RGB888,         BMP_PF_Blend_A8_L8,         BMP_PF_Blend_A8_A8         }
+};
+
+
+uint32_t BMP_PF_Bytes(BMP_PixFmt fmt)
+{
+    static const uint8_t Bytes[BMP_PF_COUNT] =
+    {
+        BMP_PF_RGB565_BYTES, BMP_PF_ARGB8888_BYTES, BMP_PF_RGB888_BYTES, BMP_PF_L8_BYTES, BMP_PF_A8_BYTES
+    };
+    return fmt < BMP_PF_COUNT ? Bytes[fmt] : 0;
+}
+
+
+// Rectangle operations. Strides are signed, so bottom-up images (BMP) can be
+// walked top-down by passing the address of the top row and a negative stride.
+void BMP_PF_Fill(BMP_PixFmt fmt, uint8_t* dst, int32_t dst_stride, uint32_t width, uint32_t height, uint32_t argb)
+{
+    if (dst == NULL || fmt >= BMP_PF_COUNT)
+        return;
+
+    Fill_fn fill = FillTable[fmt];
+    for (uint32_t y = 0; y < height; y++, dst += dst_stride)
+        fill(dst, width, argb);
+}
+
+
+void BMP_PF_Convert(BMP_PixFmt dst_fmt, uint8_t* dst, int32_t dst_stride,
+        BMP_PixFmt src_fmt, const uint8_t* src, int32_t src_stride, uint32_t width, uint32_t height)
+{
+    if (dst == NULL || src == NULL || dst_fmt >= BMP_PF_COUNT || src_fmt >= BMP_PF_COUNT)
+        return;
+
+    Convert_fn convert = ConvertTable[dst_fmt][src_fmt];
+    for (uint32_t y = 0; y < height; y++, dst += dst_stride, src += src_stride)
+        convert(dst, src, width);
+}
+
+
+void BMP_PF_Blend(BMP_PixFmt dst_fmt, uint8_t* dst, int32_t dst_stride,
+        BMP_PixFmt src_fmt, const uint8_t* src, int32_t src_stride, uint32_t width, uint32_t height, uint8_t alpha)
+{
+    if (dst == NULL || src == NULL || dst_fmt >= BMP_PF_COUNT || src_fmt >= BMP_PF_COUNT || alpha == 0)
+        return;
+
+    Blend_fn blend = BlendTable[dst_fmt][src_fmt];
+    for (uint32_t y = 0; y < height; y++, dst += dst_stride, src += src_stride)
+        blend(dst, src, width, alpha);
+}
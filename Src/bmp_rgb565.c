@@ -1,4 +1,6 @@
 #include "bmp_rgb565.h"
+#include "bmp_rgb565_hash.h"
+#include "bmp_pixfmt.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -11,6 +13,7 @@ static const uint32_t AllHeaderOffset = 70; /* FileHeaderSize + InfoHeaderSize +
 /* Private function prototypes */
 static inline uint16_t convertRGBtoRGB565(uint8_t r, uint8_t g, uint8_t b);
 static inline uint32_t Get_bytes_per_row(uint32_t width);
+static inline void Invalidate_hash(uint8_t* pbmp, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
 static uint32_t Read_uint32_t(uint8_t* pSrc);
 static uint16_t Read_uint16_t(uint8_t* pSrc);
 static void Write_uint32_t(uint32_t Src, uint8_t* pDst);
@@ -20,15 +23,32 @@ static void Write_uint16_t(uint16_t Src, uint8_t* pDst);
 uint8_t* BMP_565_Create(uint32_t width, uint32_t height)
 {
     uint8_t* pbmp;
-    uint32_t bytes_per_row = Get_bytes_per_row(width);
-    uint32_t image_size = bytes_per_row * height;
-    uint32_t data_size = AllHeaderOffset + image_size;
 
     /* Allocate the bitmap data */
-    pbmp = calloc( data_size, sizeof( uint8_t ) );
+    pbmp = calloc( BMP_565_CalcFileSize(width, height), sizeof( uint8_t ) );
     if (pbmp == NULL)
         return NULL;
 
+    BMP_565_InitHeader(pbmp, width, height);
+    return pbmp;
+}
+
+
+// Bytes needed for a complete image (headers + pixel data)
+uint32_t BMP_565_CalcFileSize(uint32_t width, uint32_t height)
+{
+    return AllHeaderOffset + Get_bytes_per_row(width) * height;
+}
+
+
+// Write the headers of a "width" x "height" image into caller-owned memory of
+// at least BMP_565_CalcFileSize() bytes. Pixel data is left untouched.
+void BMP_565_InitHeader(uint8_t* pbmp, uint32_t width, uint32_t height)
+{
+    uint32_t bytes_per_row = Get_bytes_per_row(width);
+    uint32_t image_size = bytes_per_row * height;
+    uint32_t data_size = AllHeaderOffset + image_size;
+
     // Set header's default values
     uint8_t* tmp = pbmp;
     *(tmp  +  0) = 0x42;                            // 'B' : Magic number
@@ -58,13 +78,13 @@ uint8_t* BMP_565_Create(uint32_t width, uint32_t height)
     Write_uint32_t( 0x000007E0      , tmp + 0x04);  // green
     Write_uint32_t( 0x0000001F      , tmp + 0x08);  // blue
     Write_uint32_t( 0x00000000      , tmp + 0x0C);  // reserved
-
-    return pbmp;
 }
 
 
 void BMP_565_Free(uint8_t* pbmp)
 {
+    if (pbmp != NULL)
+        BMP_565_HashDetach(pbmp);
     free(pbmp);
 }
 
@@ -91,6 +111,20 @@ uint32_t BMP_565_GetImageSize(uint8_t* pbmp)
     return Read_uint32_t(pbmp + FileHeaderSize + 0x14);
 }
 
+uint32_t BMP_565_GetBytesPerRow(uint8_t* pbmp)
+{
+    return Get_bytes_per_row(BMP_565_GetWidth(pbmp));
+}
+
+// Rows are stored bottom-up, so image row "y" lives at (height - y - 1) in the pixel data.
+uint8_t* BMP_565_GetRowAddr(uint8_t* pbmp, uint32_t y)
+{
+    uint32_t width  = BMP_565_GetWidth (pbmp);
+    uint32_t height = BMP_565_GetHeight (pbmp);
+
+    return pbmp + AllHeaderOffset + Get_bytes_per_row(width) * (height - y - 1);
+}
+
 
 void BMP_565_SetPixelRGB(uint8_t* pbmp, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b)
 {
@@ -105,6 +139,7 @@ void BMP_565_SetPixelRGB(uint8_t* pbmp, uint32_t x, uint32_t y, uint8_t r, uint8
 
     //Write_uint16_t( col, pbmp + AllHeaderOffset + bytes_per_row * (height - y - 1) + x * 2);
     Write_uint16_t( col, pbmp + AllHeaderOffset + bytes_per_row * (height - y - 1) + (x << 1));
+    Invalidate_hash(pbmp, x, y, x, y);
 }
 
 void BMP_565_GetPixelRGB(uint8_t* pbmp, uint32_t x, uint32_t y, uint8_t* r, uint8_t* g, uint8_t* b)
@@ -116,7 +151,7 @@ void BMP_565_GetPixelRGB(uint8_t* pbmp, uint32_t x, uint32_t y, uint8_t* r, uint
         return;
 
     uint32_t bytes_per_row = Get_bytes_per_row(width);
-    uint16_t col = Read_uint16_t(pbmp + bytes_per_row * (height - y - 1) + (x << 1));
+    uint16_t col = Read_uint16_t(pbmp + AllHeaderOffset + bytes_per_row * (height - y - 1) + (x << 1));
     *r = (uint8_t)(col >> 11) << 3;
     *g = (uint8_t)(col >>  5) << 2;
     *b = (uint8_t) col        << 3;
@@ -152,6 +187,9 @@ void BMP_565_DrawLineRGB(uint8_t* pbmp, int32_t x0, int32_t y0, int32_t x1, int3
 
     uint8_t* pbmp_data = pbmp + AllHeaderOffset;
 
+    // Bounding box of the line
+    Invalidate_hash(pbmp, x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0);
+
     for (;;)
     {
         Write_uint16_t( col, pbmp_data + bytes_per_row * (height - y0 - 1) + x0 * 2);
@@ -185,24 +223,19 @@ void BMP_565_DrawRectRGB(uint8_t* pbmp, uint32_t x0, uint32_t y0, uint32_t x1, u
     if (y0 > y1)
     {
         swap = y0;
-        x0 = y1;
+        y0 = y1;
         y1 = swap;
     }
 
     uint32_t bytes_per_row = Get_bytes_per_row(width);
-    uint16_t col = convertRGBtoRGB565(r, g, b);
+    uint32_t argb = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
 
-    uint8_t* pbmp_data = pbmp + AllHeaderOffset;
+    Invalidate_hash(pbmp, x0, y0, x1, y1);
 
-    uint32_t y_addr_start = bytes_per_row*(height - y0 - 1);
-    uint32_t y_addr_end   = bytes_per_row*(height - y1 - 1);
-    uint32_t x_addr_start = x0 * 2;
-    uint32_t x_addr_end   = x1 * 2;
-    for(int32_t y_addr = y_addr_start; y_addr >= y_addr_end; y_addr -= bytes_per_row)
-    {
-        for(int32_t x_addr = x_addr_start; x_addr <= x_addr_end; x_addr += 2)
-            Write_uint16_t( col, pbmp_data + y_addr + x_addr);
-    }
+    // Rows from y0 (highest address) down to y1
+    uint8_t* prow = pbmp + AllHeaderOffset + bytes_per_row * (height - y0 - 1) + (x0 << 1);
+    for (uint32_t y = y0; y <= y1; y++, prow -= bytes_per_row)
+        BMP_PF_Fill_RGB565(prow, x1 - x0 + 1, argb);
 }
 
 void BMP_565_FillRGB(uint8_t* pbmp, uint8_t r, uint8_t g, uint8_t b)
@@ -216,9 +249,11 @@ void BMP_565_FillRGB(uint8_t* pbmp, uint8_t r, uint8_t g, uint8_t b)
 
 void BMP_565_Copy(uint8_t* pbmp_Dst, uint8_t* pbmp_Src)
 {
+    // Same format on both sides, padding included: the pixel block is one contiguous copy
     uint32_t image_size = BMP_565_GetImageSize(pbmp_Src);
-    for(uint32_t i = AllHeaderOffset; i < image_size; i++)
-        *(pbmp_Dst+i) = *(pbmp_Src+i);
+    BMP_PF_Convert_RGB565_RGB565(pbmp_Dst + AllHeaderOffset, pbmp_Src + AllHeaderOffset, image_size >> 1);
+
+    Invalidate_hash(pbmp_Dst, 0, 0, BMP_565_GetWidth(pbmp_Dst) - 1, BMP_565_GetHeight(pbmp_Dst) - 1);
 }
 
 
@@ -231,6 +266,11 @@ static inline uint16_t convertRGBtoRGB565(uint8_t r, uint8_t g, uint8_t b)
           |  (uint16_t) (b >> 3);
 }
 
+static inline void Invalidate_hash(uint8_t* pbmp, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    BMP_565_HashInvalidate(pbmp, x0, y0, x1, y1);
+}
+
 // Calculate the number of bytes used to store a single image row.
 // This is always rounded up to the next multiple of 4.
 static inline uint32_t Get_bytes_per_row(uint32_t width)
@@ -0,0 +1,170 @@
+#include "bmp_rgb565_affine.h"
+#include "bmp_rgb565_hash.h"
+#include "bmp_pixfmt.h"
+#include <stdlib.h>
+#include <math.h>
+
+
+/* Private function prototypes */
+static inline int64_t  Floor_div(int64_t n, int64_t d);
+static inline void     Clip_span(int64_t u0, int32_t du, int64_t lo, int64_t hi, int32_t* xmin, int32_t* xmax);
+
+
+// Rotate by "angle" (radians, clockwise on screen) and scale around the source
+// pivot (src_cx, src_cy), which lands on (dst_cx, dst_cy) in the destination.
+void BMP_565_AffineRotate(BMP_565_Affine* m, float angle, float scale, float src_cx, float src_cy, float dst_cx, float dst_cy)
+{
+    float cs = cosf(angle) * scale;
+    float sn = sinf(angle) * scale;
+
+    m->a  = BMP_565_FIX( cs);
+    m->b  = BMP_565_FIX(-sn);
+    m->c  = BMP_565_FIX( sn);
+    m->d  = BMP_565_FIX( cs);
+    m->tx = BMP_565_FIX(dst_cx - (cs * src_cx - sn * src_cy));
+    m->ty = BMP_565_FIX(dst_cy - (sn * src_cx + cs * src_cy));
+}
+
+
+// Draw "pbmp_Src" into "pbmp_Dst" through "m". Every destination row is clipped
+// analytically to the span whose inverse-mapped pixel centres fall inside the
+// source, then walked with one fixed-point add per axis and pixel. Bilinear
+// sampling only covers the area between the outer source pixel centres.
+// Returns -1 if the matrix is singular.
+int32_t BMP_565_BlitAffine(uint8_t* pbmp_Dst, uint8_t* pbmp_Src, const BMP_565_Affine* m, BMP_565_Sample sample)
+{
+    if (pbmp_Dst == NULL || pbmp_Src == NULL || m == NULL)
+        return -1;
+
+    int32_t dst_w = (int32_t)BMP_565_GetWidth (pbmp_Dst);
+    int32_t dst_h = (int32_t)BMP_565_GetHeight(pbmp_Dst);
+    int32_t src_w = (int32_t)BMP_565_GetWidth (pbmp_Src);
+    int32_t src_h = (int32_t)BMP_565_GetHeight(pbmp_Src);
+
+    // Inverse matrix (destination -> source), 16.16
+    int64_t det = ((int64_t)m->a * m->d - (int64_t)m->b * m->c) >> 16;
+    if (det == 0)
+        return -1;
+
+    int32_t ia = (int32_t)(((int64_t) m->d << 16) / det);
+    int32_t ib = (int32_t)(((int64_t)-m->b << 16) / det);
+    int32_t ic = (int32_t)(((int64_t)-m->c << 16) / det);
+    int32_t id = (int32_t)(((int64_t) m->a << 16) / det);
+    int64_t itx = -(((int64_t)ia * m->tx + (int64_t)ib * m->ty) >> 16);
+    int64_t ity = -(((int64_t)ic * m->tx + (int64_t)id * m->ty) >> 16);
+
+    // Valid source range of the sample point. Bilinear needs the right/lower neighbour too.
+    if (sample == BMP_565_SAMPLE_BILINEAR && (src_w < 2 || src_h < 2))
+        sample = BMP_565_SAMPLE_NEAREST;
+
+    int64_t u_lo, u_hi, v_lo, v_hi;
+    int32_t bias;
+    if (sample == BMP_565_SAMPLE_BILINEAR)
+    {
+        bias = 0x8000;      // sample between pixel centres
+        u_lo = bias;
+        v_lo = bias;
+        u_hi = ((int64_t)(src_w - 1) << 16) - 1 + bias;
+        v_hi = ((int64_t)(src_h - 1) << 16) - 1 + bias;
+    }
+    else
+    {
+        bias = 0;
+        u_lo = 0;
+        v_lo = 0;
+        u_hi = ((int64_t)src_w << 16) - 1;
+        v_hi = ((int64_t)src_h << 16) - 1;
+    }
+
+    uint32_t src_stride = BMP_565_GetBytesPerRow(pbmp_Src);
+    uint32_t dst_stride = BMP_565_GetBytesPerRow(pbmp_Dst);
+    uint8_t* psrc_base  = BMP_565_GetRowAddr(pbmp_Src, src_h - 1);
+    uint8_t* pdst_row   = BMP_565_GetRowAddr(pbmp_Dst, 0);
+
+    int32_t dirty_x0 = dst_w, dirty_y0 = dst_h, dirty_x1 = -1, dirty_y1 = -1;
+
+    for (int32_t y = 0; y < dst_h; y++, pdst_row -= dst_stride)
+    {
+        // Source position of the centre of destination pixel (0, y)
+        int64_t py = ((int64_t)y << 16) + 0x8000;
+        int64_t u0 = (((int64_t)ia * 0x8000 + (int64_t)ib * py) >> 16) + itx;
+        int64_t v0 = (((int64_t)ic * 0x8000 + (int64_t)id * py) >> 16) + ity;
+
+        int32_t x0 = 0, x1 = dst_w - 1;
+        Clip_span(u0, ia, u_lo, u_hi, &x0, &x1);
+        Clip_span(v0, ic, v_lo, v_hi, &x0, &x1);
+        if (x0 > x1)
+            continue;
+
+        int32_t u = (int32_t)(u0 + (int64_t)x0 * ia) - bias;
+        int32_t v = (int32_t)(v0 + (int64_t)x0 * ic) - bias;
+        uint16_t* pd = (uint16_t*)pdst_row + x0;
+
+        if (sample == BMP_565_SAMPLE_BILINEAR)
+        {
+            for (int32_t x = x0; x <= x1; x++, u += ia, v += ic)
+            {
+                int32_t  ui = u >> 16;
+                int32_t  vi = v >> 16;
+                uint16_t* p0 = (uint16_t*)(psrc_base + src_stride * (src_h - 1 - vi)) + ui;
+                uint16_t* p1 = (uint16_t*)((uint8_t*)p0 - src_stride);
+                uint32_t fx = (u >> 11) & 0x1F;
+                uint32_t fy = (v >> 11) & 0x1F;
+
+                *pd++ = BMP_PF_Lerp565(BMP_PF_Lerp565(p0[0], p0[1], fx), BMP_PF_Lerp565(p1[0], p1[1], fx), fy);
+            }
+        }
+        else
+        {
+            for (int32_t x = x0; x <= x1; x++, u += ia, v += ic)
+                *pd++ = *((uint16_t*)(psrc_base + src_stride * (src_h - 1 - (v >> 16))) + (u >> 16));
+        }
+
+        if (x0 < dirty_x0) dirty_x0 = x0;
+        if (x1 > dirty_x1) dirty_x1 = x1;
+        if (y  < dirty_y0) dirty_y0 = y;
+        dirty_y1 = y;
+    }
+
+    if (dirty_x1 >= 0)
+        BMP_565_HashInvalidate(pbmp_Dst, dirty_x0, dirty_y0, dirty_x1, dirty_y1);
+
+    return 0;
+}
+
+
+/*********************************** Private methods **********************************/
+
+static inline int64_t Floor_div(int64_t n, int64_t d)
+{
+    int64_t q = n / d;
+    if ((n % d != 0) && ((n < 0) != (d < 0)))
+        q--;
+    return q;
+}
+
+// Narrow [*xmin, *xmax] to the x for which lo <= u0 + x * du <= hi
+static inline void Clip_span(int64_t u0, int32_t du, int64_t lo, int64_t hi, int32_t* xmin, int32_t* xmax)
+{
+    int64_t x_lo, x_hi;
+
+    if (du == 0)
+    {
+        if (u0 < lo || u0 > hi)
+            *xmax = *xmin - 1;
+        return;
+    }
+    if (du > 0)
+    {
+        x_lo = -Floor_div(u0 - lo, du);         // ceil((lo - u0) / du)
+        x_hi =  Floor_div(hi - u0, du);
+    }
+    else
+    {
+        x_lo = -Floor_div(u0 - hi, du);         // ceil((hi - u0) / du)
+        x_hi =  Floor_div(lo - u0, du);
+    }
+
+    if (x_lo > *xmin) *xmin = x_lo > *xmax ? *xmax + 1 : (int32_t)x_lo;
+    if (x_hi < *xmax) *xmax = x_hi < *xmin ? *xmin - 1 : (int32_t)x_hi;
+}
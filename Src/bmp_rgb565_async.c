@@ -0,0 +1,787 @@
+#include "bmp_rgb565_async.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef BMP_565_ASYNC_SOFTWARE
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#else
+#include "stm32f7xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
+
+
+/* Private macro */
+// DMA2D register fields (RM0385). Named D2D_ so they do not clash with the CMSIS/HAL ones.
+#define D2D_MODE_M2M            (0UL << 16)
+#define D2D_MODE_M2M_PFC        (1UL << 16)
+#define D2D_MODE_M2M_BLEND      (2UL << 16)
+#define D2D_MODE_R2M            (3UL << 16)
+#define D2D_CR_START            (1UL << 0)
+#define D2D_CR_IE               ((1UL << 8) | (1UL << 9) | (1UL << 13))     /* TEIE, TCIE, CEIE */
+#define D2D_ISR_DONE            ((1UL << 0) | (1UL << 1) | (1UL << 5))      /* TEIF, TCIF, CEIF */
+#define D2D_ISR_CTCIF           (1UL << 4)
+#define D2D_PFCCR_START         (1UL << 5)
+#define D2D_AM_MULTIPLY         (2UL << 16)
+#define D2D_CM_ARGB8888         0
+#define D2D_CM_RGB888           1
+#define D2D_CM_RGB565           2
+#define D2D_CM_L8               5
+#define D2D_CM_A8               9
+#define D2D_CM_NONE             0xFF
+
+
+/* Private type */
+// Register image of one transfer. Addresses are uintptr_t so the emulator
+// also runs on 64-bit hosts; on target they are the 32-bit register values.
+typedef struct
+{
+    uint32_t    CR;
+    uintptr_t   FGMAR;
+    uint32_t    FGOR;
+    uintptr_t   BGMAR;
+    uint32_t    BGOR;
+    uint32_t    FGPFCCR;
+    uint32_t    FGCOLR;
+    uint32_t    BGPFCCR;
+    uint32_t    OPFCCR;
+    uint32_t    OCOLR;
+    uintptr_t   OMAR;
+    uint32_t    OOR;
+    uint32_t    NLR;
+} Dma2d_regs;
+
+typedef struct
+{
+    Dma2d_regs              regs;
+    BMP_565_AsyncCallback   callback;
+    void*                   arg;
+} Async_slot;
+
+
+/* Private variables */
+static Async_slot        Queue[BMP_565_ASYNC_QUEUE_LEN];
+static volatile uint32_t Submitted;     // Fence of the last queued transfer
+static volatile uint32_t Done;          // Fence of the last finished transfer
+static volatile uint8_t  Busy;
+static volatile uint8_t  Bsp_owned;     // The DMA2D is lent to the BSP: queued transfers wait
+static uint32_t          Grey_clut[256] __attribute__((aligned(32)));
+
+#ifdef BMP_565_ASYNC_SOFTWARE
+static pthread_t        Worker;
+static pthread_mutex_t  Lock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   Start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   Done_cond  = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t  Bsp_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static Dma2d_regs       Hw_regs;        // The emulated peripheral's registers
+static volatile uint8_t Hw_start;       // CR.START
+static volatile uint8_t Hw_quit;
+#else
+static SemaphoreHandle_t Done_sem;
+static SemaphoreHandle_t Bsp_mutex;     // NULL until BMP_565_AsyncInit
+#endif
+
+
+/* Private function prototypes */
+static int32_t Build_regs(const BMP_565_AsyncCmd* cmd, Dma2d_regs* r);
+static uint8_t In_cm(uint8_t fmt);
+static uint8_t Out_cm(uint8_t fmt);
+static uint32_t Cm_bytes(uint32_t cm);
+static void Start(const Dma2d_regs* r);
+static void Complete(void);
+static void Start_next(void);
+static int32_t Wait_progress(uint32_t timeout_ms);
+static int32_t Wait_idle(uint32_t timeout_ms);
+static inline void Lock(void);
+static inline void Unlock(void);
+#ifdef BMP_565_ASYNC_SOFTWARE
+static void* Worker_thread(void* arg);
+static void Emulate(const Dma2d_regs* r);
+static uint32_t Load_pixel(uint32_t pfccr, uint32_t colr, const uint8_t* p, uint32_t i);
+static void Store_pixel(uint32_t cm, uint8_t* p, uint32_t i, uint32_t argb);
+static inline uint32_t Div255(uint32_t v);
+#endif
+
+
+// On target: clocks the DMA2D, enables its interrupt and loads the grey ramp
+// used by L8 sources into the foreground CLUT. On host: starts the emulator thread.
+int32_t BMP_565_AsyncInit(void)
+{
+    Submitted = 0;
+    Done      = 0;
+    Busy      = 0;
+    Bsp_owned = 0;
+    for (uint32_t i = 0; i < 256; i++)
+        Grey_clut[i] = 0xFF000000UL | i * 0x00010101UL;
+
+#ifdef BMP_565_ASYNC_SOFTWARE
+    Hw_start = 0;
+    Hw_quit  = 0;
+    if (pthread_create(&Worker, NULL, Worker_thread, NULL) != 0)
+        return -1;
+#else
+    if (Done_sem == NULL)
+        Done_sem = xSemaphoreCreateBinary();
+    if (Done_sem == NULL)
+        return -1;
+    if (Bsp_mutex == NULL)
+        Bsp_mutex = xSemaphoreCreateMutex();
+    if (Bsp_mutex == NULL)
+        return -1;
+
+    __HAL_RCC_DMA2D_CLK_ENABLE();
+    SCB_CleanDCache_by_Addr(Grey_clut, sizeof(Grey_clut));
+    DMA2D->FGCMAR  = (uint32_t)Grey_clut;
+    DMA2D->FGPFCCR = (255UL << 8) | D2D_PFCCR_START;
+    while (!(DMA2D->ISR & D2D_ISR_CTCIF))
+        ;
+    DMA2D->IFCR = D2D_ISR_CTCIF;
+
+    HAL_NVIC_SetPriority(DMA2D_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+#endif
+    return 0;
+}
+
+
+// Waits for the queue to drain, then stops the engine
+void BMP_565_AsyncDeinit(void)
+{
+    BMP_565_AsyncFlush(BMP_565_ASYNC_WAIT_FOREVER);
+
+#ifdef BMP_565_ASYNC_SOFTWARE
+    Lock();
+    Hw_quit = 1;
+    pthread_cond_signal(&Start_cond);
+    Unlock();
+    pthread_join(Worker, NULL);
+#else
+    HAL_NVIC_DisableIRQ(DMA2D_IRQn);
+#endif
+}
+
+
+// Queue a transfer; blocks while the queue is full.
+// Returns its fence, or 0 if the descriptor is not something the DMA2D can do.
+uint32_t BMP_565_AsyncSubmit(const BMP_565_AsyncCmd* cmd)
+{
+    Dma2d_regs regs;
+    if (cmd == NULL || Build_regs(cmd, &regs) != 0)
+        return 0;
+
+    Lock();
+    while (Submitted - Done >= BMP_565_ASYNC_QUEUE_LEN)
+    {
+        Unlock();
+        Wait_progress(BMP_565_ASYNC_WAIT_FOREVER);
+        Lock();
+    }
+
+    uint32_t    fence = ++Submitted;
+    Async_slot* slot  = &Queue[fence % BMP_565_ASYNC_QUEUE_LEN];
+    slot->regs     = regs;
+    slot->callback = cmd->callback;
+    slot->arg      = cmd->arg;
+    if (!Busy && !Bsp_owned)
+        Start_next();
+    Unlock();
+
+    return fence;
+}
+
+
+uint8_t BMP_565_AsyncIsDone(uint32_t fence)
+{
+    return (int32_t)(Done - fence) >= 0;
+}
+
+
+// Returns 0 once transfer "fence" and everything before it is done, -1 on timeout.
+// "timeout_ms" applies to each completion waited for.
+int32_t BMP_565_AsyncWait(uint32_t fence, uint32_t timeout_ms)
+{
+    if ((int32_t)(Submitted - fence) < 0)
+        return -1;
+
+    while (!BMP_565_AsyncIsDone(fence))
+    {
+        if (Wait_progress(timeout_ms) != 0 && !BMP_565_AsyncIsDone(fence))
+            return -1;
+    }
+    return 0;
+}
+
+
+int32_t BMP_565_AsyncFlush(uint32_t timeout_ms)
+{
+    return BMP_565_AsyncWait(Submitted, timeout_ms);
+}
+
+
+// Take the DMA2D for a BSP_LCD drawing function (FillRect, DrawBitmap, ...),
+// which programs the DMA2D itself and polls it. Waits for the running transfer;
+// queued ones are held until BMP_565_AsyncBspRelease. Any number of tasks may
+// call this: they take turns. Returns 0, or -1 on timeout (nothing is held then).
+// Without BMP_565_AsyncInit there is nothing to share and this returns at once.
+int32_t BMP_565_AsyncBspAcquire(uint32_t timeout_ms)
+{
+#ifdef BMP_565_ASYNC_SOFTWARE
+    if (timeout_ms == BMP_565_ASYNC_WAIT_FOREVER)
+        pthread_mutex_lock(&Bsp_mutex);
+    else
+    {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec  += timeout_ms / 1000;
+        until.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (until.tv_nsec >= 1000000000L)
+        {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        if (pthread_mutex_timedlock(&Bsp_mutex, &until) != 0)
+            return -1;
+    }
+#else
+    if (Bsp_mutex == NULL)
+        return 0;
+    TickType_t ticks = timeout_ms == BMP_565_ASYNC_WAIT_FOREVER ? portMAX_DELAY : (TickType_t)(timeout_ms / portTICK_PERIOD_MS);
+    if (xSemaphoreTake(Bsp_mutex, ticks) != pdTRUE)
+        return -1;
+#endif
+
+    Lock();
+    Bsp_owned = 1;
+    Unlock();
+
+    // Complete() does not start another transfer now, so once idle the DMA2D
+    // is free and its interrupt enables are cleared
+    if (Wait_idle(timeout_ms) != 0)
+    {
+        BMP_565_AsyncBspRelease();
+        return -1;
+    }
+    return 0;
+}
+
+
+// Give the DMA2D back after BMP_565_AsyncBspAcquire and restart the queue
+void BMP_565_AsyncBspRelease(void)
+{
+#ifndef BMP_565_ASYNC_SOFTWARE
+    if (Bsp_mutex == NULL)
+        return;
+#endif
+
+    Lock();
+    Bsp_owned = 0;
+    if (!Busy && Done != Submitted)
+        Start_next();
+    Unlock();
+
+#ifdef BMP_565_ASYNC_SOFTWARE
+    pthread_mutex_unlock(&Bsp_mutex);
+#else
+    xSemaphoreGive(Bsp_mutex);
+#endif
+}
+
+
+// Call from DMA2D_IRQHandler
+void BMP_565_AsyncIRQHandler(void)
+{
+#ifndef BMP_565_ASYNC_SOFTWARE
+    // Not ours: a polled BSP transfer owns the flags. Only mask the interrupt.
+    if (!Busy)
+    {
+        DMA2D->CR &= ~D2D_CR_IE;
+        return;
+    }
+
+    uint32_t isr = DMA2D->ISR & D2D_ISR_DONE;
+    DMA2D->IFCR = isr;
+
+    // An error ends the transfer as well: complete it so the queue keeps moving
+    if (isr != 0)
+        Complete();
+#endif
+}
+
+
+// Fill the inclusive rectangle, as BMP_565_DrawRectRGB
+uint32_t BMP_565_AsyncFillRGB(uint8_t* pbmp, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (pbmp == NULL || x0 > x1 || y0 > y1 || x1 >= BMP_565_GetWidth(pbmp) || y1 >= BMP_565_GetHeight(pbmp))
+        return 0;
+
+    BMP_565_AsyncCmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.op         = BMP_565_ASYNC_FILL;
+    cmd.dst_fmt    = BMP_PF_RGB565;
+    cmd.color      = 0xFF000000UL | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    cmd.width      = x1 - x0 + 1;
+    cmd.height     = y1 - y0 + 1;
+    // Image rows are stored bottom-up: start at the bottom row so lines go up in memory
+    cmd.dst        = BMP_565_GetRowAddr(pbmp, y1) + (x0 << 1);
+    cmd.dst_offset = (BMP_565_GetBytesPerRow(pbmp) >> 1) - cmd.width;
+
+    BMP_565_HashInvalidate(pbmp, x0, y0, x1, y1);
+    return BMP_565_AsyncSubmit(&cmd);
+}
+
+
+// Copy all of "pbmp_Src" to (x, y), clipped
+uint32_t BMP_565_AsyncCopy(uint8_t* pbmp_Dst, int32_t x, int32_t y, uint8_t* pbmp_Src)
+{
+    if (pbmp_Dst == NULL || pbmp_Src == NULL)
+        return 0;
+
+    int32_t dw = BMP_565_GetWidth(pbmp_Dst), dh = BMP_565_GetHeight(pbmp_Dst);
+    int32_t sw = BMP_565_GetWidth(pbmp_Src), sh = BMP_565_GetHeight(pbmp_Src);
+    int32_t col0 = x < 0 ? -x : 0;
+    int32_t row0 = y < 0 ? -y : 0;
+    int32_t col1 = x + sw > dw ? dw - x : sw;
+    int32_t row1 = y + sh > dh ? dh - y : sh;
+    if (col0 >= col1 || row0 >= row1)
+        return 0;
+
+    BMP_565_AsyncCmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.op         = BMP_565_ASYNC_COPY;
+    cmd.dst_fmt    = BMP_PF_RGB565;
+    cmd.src_fmt    = BMP_PF_RGB565;
+    cmd.width      = col1 - col0;
+    cmd.height     = row1 - row0;
+    cmd.dst        = BMP_565_GetRowAddr(pbmp_Dst, y + row1 - 1) + ((x + col0) << 1);
+    cmd.dst_offset = (BMP_565_GetBytesPerRow(pbmp_Dst) >> 1) - cmd.width;
+    cmd.src        = BMP_565_GetRowAddr(pbmp_Src, row1 - 1) + (col0 << 1);
+    cmd.src_offset = (BMP_565_GetBytesPerRow(pbmp_Src) >> 1) - cmd.width;
+
+    BMP_565_HashInvalidate(pbmp_Dst, x + col0, y + row0, x + col1 - 1, y + row1 - 1);
+    return BMP_565_AsyncSubmit(&cmd);
+}
+
+
+// Blend "src" (width x height, packed, bottom row first like a BMP) over
+// "pbmp_Dst" at (x, y), clipped. "alpha" scales the source alpha. An A8 source
+// is a coverage mask painted in "color" (0xRRGGBB); other formats ignore it.
+uint32_t BMP_565_AsyncBlend(uint8_t* pbmp_Dst, int32_t x, int32_t y, BMP_PixFmt src_fmt, const uint8_t* src,
+                            uint32_t width, uint32_t height, uint8_t alpha, uint32_t color)
+{
+    if (pbmp_Dst == NULL || src == NULL || In_cm(src_fmt) == D2D_CM_NONE)
+        return 0;
+
+    int32_t dw = BMP_565_GetWidth(pbmp_Dst), dh = BMP_565_GetHeight(pbmp_Dst);
+    int32_t sw = width, sh = height;
+    int32_t col0 = x < 0 ? -x : 0;
+    int32_t row0 = y < 0 ? -y : 0;
+    int32_t col1 = x + sw > dw ? dw - x : sw;
+    int32_t row1 = y + sh > dh ? dh - y : sh;
+    if (col0 >= col1 || row0 >= row1)
+        return 0;
+
+    uint32_t bytes = BMP_PF_Bytes(src_fmt);
+    BMP_565_AsyncCmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.op         = BMP_565_ASYNC_BLEND;
+    cmd.dst_fmt    = BMP_PF_RGB565;
+    cmd.src_fmt    = src_fmt;
+    cmd.alpha      = alpha;
+    cmd.color      = color;
+    cmd.width      = col1 - col0;
+    cmd.height     = row1 - row0;
+    cmd.dst        = BMP_565_GetRowAddr(pbmp_Dst, y + row1 - 1) + ((x + col0) << 1);
+    cmd.dst_offset = (BMP_565_GetBytesPerRow(pbmp_Dst) >> 1) - cmd.width;
+    cmd.src        = src + ((uint32_t)(sh - row1) * width + col0) * bytes;
+    cmd.src_offset = width - cmd.width;
+
+    BMP_565_HashInvalidate(pbmp_Dst, x + col0, y + row0, x + col1 - 1, y + row1 - 1);
+    return BMP_565_AsyncSubmit(&cmd);
+}
+
+
+/*********************************** Private methods **********************************/
+
+static int32_t Build_regs(const BMP_565_AsyncCmd* cmd, Dma2d_regs* r)
+{
+    uint8_t ocm = Out_cm(cmd->dst_fmt);
+    uint8_t fcm = In_cm(cmd->src_fmt);
+
+    // NLR.PL and the offsets are 14-bit fields
+    if (cmd->dst == NULL || ocm == D2D_CM_NONE || cmd->width == 0 || cmd->height == 0 || cmd->width > 0x3FFF ||
+        cmd->dst_offset > 0x3FFF || cmd->src_offset > 0x3FFF || cmd->bg_offset > 0x3FFF)
+        return -1;
+    if (cmd->op != BMP_565_ASYNC_FILL && (cmd->src == NULL || fcm == D2D_CM_NONE))
+        return -1;
+
+    memset(r, 0, sizeof(Dma2d_regs));
+    r->OMAR    = (uintptr_t)cmd->dst;
+    r->OOR     = cmd->dst_offset;
+    r->OPFCCR  = ocm;
+    r->NLR     = ((uint32_t)cmd->width << 16) | cmd->height;
+    r->FGMAR   = (uintptr_t)cmd->src;
+    r->FGOR    = cmd->src_offset;
+    r->FGPFCCR = fcm;
+    r->FGCOLR  = cmd->color & 0x00FFFFFFUL;
+
+    switch (cmd->op)
+    {
+    case BMP_565_ASYNC_FILL:
+        // OCOLR holds the colour in the output format
+        r->CR    = D2D_MODE_R2M;
+        r->OCOLR = ocm == D2D_CM_RGB565 ? BMP_PF_8888to565(cmd->color)
+                 : ocm == D2D_CM_RGB888 ? cmd->color & 0x00FFFFFFUL : cmd->color;
+        break;
+
+    case BMP_565_ASYNC_COPY:
+        if (fcm != ocm)
+            return -1;
+        r->CR = D2D_MODE_M2M;
+        break;
+
+    case BMP_565_ASYNC_CONVERT:
+        r->CR = D2D_MODE_M2M_PFC;
+        break;
+
+    case BMP_565_ASYNC_BLEND:
+        r->CR       = D2D_MODE_M2M_BLEND;
+        r->FGPFCCR |= D2D_AM_MULTIPLY | ((uint32_t)cmd->alpha << 24);
+        r->BGMAR    = cmd->bg != NULL ? (uintptr_t)cmd->bg : (uintptr_t)cmd->dst;
+        r->BGOR     = cmd->bg != NULL ? cmd->bg_offset : cmd->dst_offset;
+        r->BGPFCCR  = ocm;
+        break;
+
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+static uint8_t In_cm(uint8_t fmt)
+{
+    switch (fmt)
+    {
+    case BMP_PF_RGB565:     return D2D_CM_RGB565;
+    case BMP_PF_ARGB8888:   return D2D_CM_ARGB8888;
+    case BMP_PF_RGB888:     return D2D_CM_RGB888;
+    case BMP_PF_L8:         return D2D_CM_L8;
+    case BMP_PF_A8:         return D2D_CM_A8;
+    default:                return D2D_CM_NONE;
+    }
+}
+
+// The DMA2D writes only direct-colour formats
+static uint8_t Out_cm(uint8_t fmt)
+{
+    uint8_t cm = In_cm(fmt);
+    return cm <= D2D_CM_RGB565 ? cm : D2D_CM_NONE;
+}
+
+static uint32_t Cm_bytes(uint32_t cm)
+{
+    return cm == D2D_CM_ARGB8888 ? 4 : cm == D2D_CM_RGB888 ? 3 : cm == D2D_CM_RGB565 ? 2 : 1;
+}
+
+// Start the oldest queued transfer. Called with the lock held.
+static void Start_next(void)
+{
+    Busy = 1;
+    Start(&Queue[(Done + 1) % BMP_565_ASYNC_QUEUE_LEN].regs);
+}
+
+// Called with the lock held, from the task that completed the previous transfer or from Submit
+static void Start(const Dma2d_regs* r)
+{
+#ifdef BMP_565_ASYNC_SOFTWARE
+    Hw_regs  = *r;
+    Hw_start = 1;
+    pthread_cond_signal(&Start_cond);
+#else
+    uint32_t pl = (r->NLR >> 16) & 0x3FFF, nl = r->NLR & 0xFFFF;
+    uint32_t mode = r->CR & D2D_MODE_R2M;
+
+    // The D-cache is on: push pending CPU writes of the inputs out to memory and
+    // drop the cached output lines, so neither side sees stale pixels
+    if (mode != D2D_MODE_R2M)
+        SCB_CleanDCache_by_Addr((uint32_t*)(r->FGMAR & ~31UL),
+                ((pl + r->FGOR) * (nl - 1) + pl) * Cm_bytes(r->FGPFCCR & 0x0F) + (r->FGMAR & 31));
+    if (mode == D2D_MODE_M2M_BLEND)
+        SCB_CleanDCache_by_Addr((uint32_t*)(r->BGMAR & ~31UL),
+                ((pl + r->BGOR) * (nl - 1) + pl) * Cm_bytes(r->BGPFCCR & 0x0F) + (r->BGMAR & 31));
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t*)(r->OMAR & ~31UL),
+            ((pl + r->OOR) * (nl - 1) + pl) * Cm_bytes(r->OPFCCR & 0x07) + (r->OMAR & 31));
+
+    DMA2D->FGMAR   = r->FGMAR;
+    DMA2D->FGOR    = r->FGOR;
+    DMA2D->FGPFCCR = r->FGPFCCR;
+    DMA2D->FGCOLR  = r->FGCOLR;
+    DMA2D->BGMAR   = r->BGMAR;
+    DMA2D->BGOR    = r->BGOR;
+    DMA2D->BGPFCCR = r->BGPFCCR;
+    DMA2D->OPFCCR  = r->OPFCCR;
+    DMA2D->OCOLR   = r->OCOLR;
+    DMA2D->OMAR    = r->OMAR;
+    DMA2D->OOR     = r->OOR;
+    DMA2D->NLR     = r->NLR;
+    DMA2D->CR      = r->CR | D2D_CR_IE | D2D_CR_START;
+#endif
+}
+
+// End of the running transfer: start the next one, then report
+static void Complete(void)
+{
+#ifdef BMP_565_ASYNC_SOFTWARE
+    Lock();
+#else
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    const Dma2d_regs* r = &Queue[(Done + 1) % BMP_565_ASYNC_QUEUE_LEN].regs;
+    uint32_t pl = (r->NLR >> 16) & 0x3FFF, nl = r->NLR & 0xFFFF;
+    SCB_InvalidateDCache_by_Addr((uint32_t*)(r->OMAR & ~31UL),
+            ((pl + r->OOR) * (nl - 1) + pl) * Cm_bytes(r->OPFCCR & 0x07) + (r->OMAR & 31));
+#endif
+
+    uint32_t    fence = ++Done;
+    Async_slot* slot  = &Queue[fence % BMP_565_ASYNC_QUEUE_LEN];
+    BMP_565_AsyncCallback callback = slot->callback;
+    void*       arg   = slot->arg;
+
+    if (Done != Submitted && !Bsp_owned)
+        Start_next();
+    else
+    {
+        // Idle: leave no interrupt enabled for the BSP's polled transfers to raise
+        Busy = 0;
+#ifndef BMP_565_ASYNC_SOFTWARE
+        DMA2D->CR &= ~D2D_CR_IE;
+#endif
+    }
+
+#ifdef BMP_565_ASYNC_SOFTWARE
+    pthread_cond_broadcast(&Done_cond);
+    Unlock();
+    if (callback != NULL)
+        callback(fence, arg);
+#else
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    if (callback != NULL)
+        callback(fence, arg);
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(Done_sem, &woken);
+    portYIELD_FROM_ISR(woken);
+#endif
+}
+
+// Sleep until some transfer completes; -1 if "timeout_ms" passed first.
+// On target only one task should be waiting at a time.
+static int32_t Wait_progress(uint32_t timeout_ms)
+{
+#ifdef BMP_565_ASYNC_SOFTWARE
+    int32_t  ret    = 0;
+    uint32_t before = Done;
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec  += timeout_ms / 1000;
+    until.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (until.tv_nsec >= 1000000000L)
+    {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+
+    Lock();
+    while (Done == before && Busy)
+    {
+        if (timeout_ms == BMP_565_ASYNC_WAIT_FOREVER)
+            pthread_cond_wait(&Done_cond, &Lock_mutex);
+        else if (pthread_cond_timedwait(&Done_cond, &Lock_mutex, &until) == ETIMEDOUT)
+        {
+            ret = -1;
+            break;
+        }
+    }
+    Unlock();
+    return ret;
+#else
+    TickType_t ticks = timeout_ms == BMP_565_ASYNC_WAIT_FOREVER ? portMAX_DELAY : (TickType_t)(timeout_ms / portTICK_PERIOD_MS);
+    return xSemaphoreTake(Done_sem, ticks) == pdTRUE ? 0 : -1;
+#endif
+}
+
+// Wait until no transfer is running. Polls on target: the completion semaphore
+// belongs to the fence waiters, and a running transfer takes well under a tick.
+static int32_t Wait_idle(uint32_t timeout_ms)
+{
+#ifdef BMP_565_ASYNC_SOFTWARE
+    while (Busy)
+    {
+        if (Wait_progress(timeout_ms) != 0 && Busy)
+            return -1;
+    }
+#else
+    TickType_t start = xTaskGetTickCount();
+    TickType_t ticks = (TickType_t)(timeout_ms / portTICK_PERIOD_MS);
+    while (Busy)
+    {
+        if (timeout_ms != BMP_565_ASYNC_WAIT_FOREVER && xTaskGetTickCount() - start >= ticks)
+            return -1;
+        vTaskDelay(1);
+    }
+#endif
+    return 0;
+}
+
+static inline void Lock(void)
+{
+#ifdef BMP_565_ASYNC_SOFTWARE
+    pthread_mutex_lock(&Lock_mutex);
+#else
+    taskENTER_CRITICAL();
+#endif
+}
+
+static inline void Unlock(void)
+{
+#ifdef BMP_565_ASYNC_SOFTWARE
+    pthread_mutex_unlock(&Lock_mutex);
+#else
+    taskEXIT_CRITICAL();
+#endif
+}
+
+#ifdef BMP_565_ASYNC_SOFTWARE
+
+// The emulated peripheral: waits for CR.START, runs the transfer from its
+// register copy, then raises "transfer complete"
+static void* Worker_thread(void* arg)
+{
+    (void)arg;
+
+    Lock();
+    while (!Hw_quit)
+    {
+        if (!Hw_start)
+        {
+            pthread_cond_wait(&Start_cond, &Lock_mutex);
+            continue;
+        }
+        Dma2d_regs regs = Hw_regs;
+        Unlock();
+
+        Emulate(&regs);
+
+        Lock();
+        Hw_start = 0;
+        Unlock();
+        Complete();
+        Lock();
+    }
+    Unlock();
+    return NULL;
+}
+
+// One transfer, following the RM0385 description of each mode
+static void Emulate(const Dma2d_regs* r)
+{
+    uint32_t mode = r->CR & D2D_MODE_R2M;
+    uint32_t pl   = (r->NLR >> 16) & 0x3FFF;
+    uint32_t nl   = r->NLR & 0xFFFF;
+    uint32_t ocm  = r->OPFCCR & 0x07;
+    uint32_t fcm  = r->FGPFCCR & 0x0F;
+    uint32_t bcm  = r->BGPFCCR & 0x0F;
+    uint32_t bcolr = 0;
+    // Memory-to-memory copies without PFC use the foreground pixel size for the output
+    uint32_t ob   = Cm_bytes(mode == D2D_MODE_M2M ? fcm : ocm);
+    uint32_t fb   = Cm_bytes(fcm);
+    uint32_t bb   = Cm_bytes(bcm);
+
+    for (uint32_t line = 0; line < nl; line++)
+    {
+        uint8_t*       out = (uint8_t*)r->OMAR + line * (pl + r->OOR) * ob;
+        const uint8_t* fg  = (const uint8_t*)r->FGMAR + line * (pl + r->FGOR) * fb;
+        const uint8_t* bg  = (const uint8_t*)r->BGMAR + line * (pl + r->BGOR) * bb;
+
+        switch (mode)
+        {
+        case D2D_MODE_R2M:
+            for (uint32_t i = 0; i < pl; i++)
+            {
+                if (ocm == D2D_CM_RGB565)
+                    BMP_PF_RGB565_PUT(out, i, r->OCOLR);
+                else if (ocm == D2D_CM_RGB888)
+                    BMP_PF_RGB888_PUT(out, i, r->OCOLR);
+                else
+                    BMP_PF_ARGB8888_PUT(out, i, r->OCOLR);
+            }
+            break;
+
+        case D2D_MODE_M2M:
+            memmove(out, fg, pl * fb);
+            break;
+
+        case D2D_MODE_M2M_PFC:
+            for (uint32_t i = 0; i < pl; i++)
+                Store_pixel(ocm, out, i, Load_pixel(r->FGPFCCR, r->FGCOLR, fg, i));
+            break;
+
+        case D2D_MODE_M2M_BLEND:
+            for (uint32_t i = 0; i < pl; i++)
+            {
+                uint32_t f  = Load_pixel(r->FGPFCCR, r->FGCOLR, fg, i);
+                uint32_t b  = Load_pixel(r->BGPFCCR, bcolr, bg, i);
+                uint32_t fa = f >> 24, ba = b >> 24;
+                uint32_t ma = Div255(fa * ba);
+                uint32_t oa = fa + ba - ma;
+                uint32_t c  = oa << 24;
+
+                for (uint32_t sh = 0; sh < 24 && oa != 0; sh += 8)
+                {
+                    uint32_t fc = (f >> sh) & 0xFF, bc = (b >> sh) & 0xFF;
+                    c |= ((fc * fa + bc * ba - bc * ma + (oa >> 1)) / oa) << sh;
+                }
+                Store_pixel(ocm, out, i, c);
+            }
+            break;
+        }
+    }
+}
+
+// Foreground/background pixel as 0xAARRGGBB after the layer's alpha mode is applied
+static uint32_t Load_pixel(uint32_t pfccr, uint32_t colr, const uint8_t* p, uint32_t i)
+{
+    uint32_t c;
+    switch (pfccr & 0x0F)
+    {
+    case D2D_CM_ARGB8888:   c = BMP_PF_ARGB8888_LOAD(p, i);                 break;
+    case D2D_CM_RGB888:     c = BMP_PF_RGB888_LOAD(p, i);                   break;
+    case D2D_CM_RGB565:     c = BMP_PF_RGB565_LOAD(p, i);                   break;
+    case D2D_CM_L8:         c = Grey_clut[p[i]];                            break;
+    default:                c = ((uint32_t)p[i] << 24) | colr;              break;
+    }
+
+    if (pfccr & D2D_AM_MULTIPLY)
+        c = (Div255((c >> 24) * (pfccr >> 24)) << 24) | (c & 0x00FFFFFFUL);
+    return c;
+}
+
+static void Store_pixel(uint32_t cm, uint8_t* p, uint32_t i, uint32_t argb)
+{
+    if (cm == D2D_CM_RGB565)
+        BMP_PF_RGB565_PUT(p, i, BMP_PF_8888to565(argb));
+    else if (cm == D2D_CM_RGB888)
+        BMP_PF_RGB888_PUT(p, i, argb);
+    else
+        BMP_PF_ARGB8888_PUT(p, i, argb);
+}
+
+// v / 255 rounded, for v <= 255 * 255
+static inline uint32_t Div255(uint32_t v)
+{
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+#endif
@@ -0,0 +1,247 @@
+#include "bmp_rgb565_atlas.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Private function prototypes */
+static void Blit_sprite(uint8_t* pbmp_Dst, BMP_565_Atlas* atlas, const BMP_565_AtlasEntry* e, int32_t dx, int32_t dy);
+static void Free_runs(BMP_565_Atlas* atlas);
+
+
+// Allocate the atlas image. Returns 0 on success, -1 on allocation failure.
+int32_t BMP_565_AtlasCreate(BMP_565_Atlas* atlas, uint32_t width, uint32_t height)
+{
+    if (atlas == NULL)
+        return -1;
+
+    memset(atlas, 0, sizeof(BMP_565_Atlas));
+    atlas->pbmp = BMP_565_Create(width, height);
+    if (atlas->pbmp == NULL)
+        return -1;
+
+    return 0;
+}
+
+
+void BMP_565_AtlasFree(BMP_565_Atlas* atlas)
+{
+    if (atlas == NULL)
+        return;
+
+    Free_runs(atlas);
+    BMP_565_Free(atlas->pbmp);
+    atlas->pbmp  = NULL;
+    atlas->count = 0;
+}
+
+
+// Shelf packer: sprites are placed left to right on the current shelf, and a
+// new shelf is opened below when the row is full. Adding sprites tallest first
+// wastes the least space. Returns the sprite index, or -1 if it does not fit.
+int32_t BMP_565_AtlasAdd(BMP_565_Atlas* atlas, uint32_t id, uint8_t* pbmp_Src)
+{
+    if (atlas == NULL || atlas->pbmp == NULL || pbmp_Src == NULL || atlas->count >= BMP_565_ATLAS_MAX_SPRITES)
+        return -1;
+    if (BMP_565_AtlasFind(atlas, id) >= 0)
+        return -1;
+
+    uint32_t atlas_w = BMP_565_GetWidth (atlas->pbmp);
+    uint32_t atlas_h = BMP_565_GetHeight(atlas->pbmp);
+    uint32_t w = BMP_565_GetWidth (pbmp_Src);
+    uint32_t h = BMP_565_GetHeight(pbmp_Src);
+
+    if (w == 0 || h == 0 || w > atlas_w)
+        return -1;
+
+    // Open a new shelf? Checked before touching the shelf state, so a sprite
+    // that does not fit leaves the current shelf usable.
+    uint32_t new_shelf = atlas->cursor_x + w > atlas_w;
+    uint32_t shelf_y   = new_shelf ? atlas->shelf_y + atlas->shelf_h : atlas->shelf_y;
+    if (shelf_y + h > atlas_h)
+        return -1;
+    if (new_shelf)
+    {
+        atlas->shelf_y  = shelf_y;
+        atlas->shelf_h  = 0;
+        atlas->cursor_x = 0;
+    }
+
+    BMP_565_AtlasEntry* e = &atlas->entry[atlas->count];
+    e->x = atlas->cursor_x;
+    e->y = atlas->shelf_y;
+    e->w = w;
+    e->h = h;
+
+    atlas->cursor_x += w;
+    if (h > atlas->shelf_h)
+        atlas->shelf_h = h;
+
+    for (uint32_t y = 0; y < h; y++)
+        memcpy(BMP_565_GetRowAddr(atlas->pbmp, e->y + y) + (e->x << 1), BMP_565_GetRowAddr(pbmp_Src, y), w << 1);
+    BMP_565_HashInvalidate(atlas->pbmp, e->x, e->y, e->x + w - 1, e->y + h - 1);
+
+    // Insert into the id lookup, keeping it sorted
+    uint32_t i = atlas->count;
+    while (i > 0 && atlas->lookup[i - 1].id > id)
+    {
+        atlas->lookup[i] = atlas->lookup[i - 1];
+        i--;
+    }
+    atlas->lookup[i].id    = id;
+    atlas->lookup[i].index = atlas->count;
+
+    return atlas->count++;
+}
+
+
+// Binary search of the id lookup. Returns the sprite index, or -1.
+int32_t BMP_565_AtlasFind(BMP_565_Atlas* atlas, uint32_t id)
+{
+    if (atlas == NULL)
+        return -1;
+
+    int32_t lo = 0;
+    int32_t hi = (int32_t)atlas->count - 1;
+    while (lo <= hi)
+    {
+        int32_t mid = (lo + hi) >> 1;
+        if (atlas->lookup[mid].id == id)
+            return atlas->lookup[mid].index;
+        if (atlas->lookup[mid].id < id)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+
+// FNV-1a, for callers that prefer to key sprites by name
+uint32_t BMP_565_AtlasNameId(const char* name)
+{
+    uint32_t h = 0x811C9DC5UL;
+
+    while (name != NULL && *name != 0)
+    {
+        h ^= (uint8_t)*name++;
+        h *= 0x01000193UL;
+    }
+    return h;
+}
+
+
+int32_t BMP_565_AtlasGetRect(BMP_565_Atlas* atlas, uint32_t sprite, BMP_565_Rect* rect)
+{
+    if (atlas == NULL || rect == NULL || sprite >= atlas->count)
+        return -1;
+
+    const BMP_565_AtlasEntry* e = &atlas->entry[sprite];
+    rect->x0 = e->x;
+    rect->y0 = e->y;
+    rect->x1 = e->x + e->w - 1;
+    rect->y1 = e->y + e->h - 1;
+    return 0;
+}
+
+
+void BMP_565_AtlasSetColorKey(BMP_565_Atlas* atlas, uint8_t enable, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (atlas == NULL)
+        return;
+
+    uint16_t key = COL_RGB565(r, g, b);
+    if (key != atlas->key)
+        Free_runs(atlas);
+
+    atlas->use_key = enable;
+    atlas->key     = key;
+    atlas->key_rgb = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+
+// Draw a batch of sprite instances into "pbmp_Dst", in array order.
+// With a colour key, each sprite is encoded into opaque runs the first time it
+// is drawn and blitted with BMP_565_BlitRuns() from then on.
+void BMP_565_AtlasBlit(uint8_t* pbmp_Dst, BMP_565_Atlas* atlas, const BMP_565_SpriteInst* inst, uint32_t count)
+{
+    if (pbmp_Dst == NULL || atlas == NULL || atlas->pbmp == NULL || inst == NULL)
+        return;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t sprite = inst[i].sprite;
+        if (sprite >= atlas->count)
+            continue;
+
+        if (atlas->use_key)
+        {
+            if (atlas->runs[sprite] == NULL)
+            {
+                BMP_565_Rect rect;
+                BMP_565_AtlasGetRect(atlas, sprite, &rect);
+                atlas->runs[sprite] = BMP_565_RunsFromKey(atlas->pbmp, &rect, COL_RGB_SET(atlas->key_rgb));
+            }
+            if (atlas->runs[sprite] != NULL)
+            {
+                BMP_565_BlitRuns(pbmp_Dst, inst[i].x, inst[i].y, atlas->pbmp, atlas->runs[sprite]);
+                continue;
+            }
+        }
+        Blit_sprite(pbmp_Dst, atlas, &atlas->entry[inst[i].sprite], inst[i].x, inst[i].y);
+    }
+}
+
+
+/*********************************** Private methods **********************************/
+
+static void Blit_sprite(uint8_t* pbmp_Dst, BMP_565_Atlas* atlas, const BMP_565_AtlasEntry* e, int32_t dx, int32_t dy)
+{
+    int32_t width  = (int32_t)BMP_565_GetWidth (pbmp_Dst);
+    int32_t height = (int32_t)BMP_565_GetHeight(pbmp_Dst);
+
+    // Clip
+    int32_t sx = 0, sy = 0;
+    int32_t w = e->w, h = e->h;
+    if (dx < 0) { sx = -dx; w += dx; dx = 0; }
+    if (dy < 0) { sy = -dy; h += dy; dy = 0; }
+    if (dx + w > width)  w = width  - dx;
+    if (dy + h > height) h = height - dy;
+    if (w <= 0 || h <= 0)
+        return;
+
+    // Rows are stored bottom-up: the next image row is one stride lower in memory
+    uint32_t src_stride = BMP_565_GetBytesPerRow(atlas->pbmp);
+    uint32_t dst_stride = BMP_565_GetBytesPerRow(pbmp_Dst);
+    uint8_t* psrc = BMP_565_GetRowAddr(atlas->pbmp, e->y + sy) + ((e->x + sx) << 1);
+    uint8_t* pdst = BMP_565_GetRowAddr(pbmp_Dst, dy) + (dx << 1);
+
+    for (int32_t y = 0; y < h; y++, psrc -= src_stride, pdst -= dst_stride)
+    {
+        uint16_t* ps = (uint16_t*)psrc;
+        uint16_t* pd = (uint16_t*)pdst;
+
+        if (!atlas->use_key)
+        {
+            memcpy(pd, ps, w << 1);
+            continue;
+        }
+        // Fallback when the runs could not be allocated
+        for (int32_t x = 0; x < w; x++)
+        {
+            if (ps[x] != atlas->key)
+                pd[x] = ps[x];
+        }
+    }
+
+    BMP_565_HashInvalidate(pbmp_Dst, dx, dy, dx + w - 1, dy + h - 1);
+}
+
+static void Free_runs(BMP_565_Atlas* atlas)
+{
+    for (uint32_t i = 0; i < BMP_565_ATLAS_MAX_SPRITES; i++)
+    {
+        BMP_565_RunsFree(atlas->runs[i]);
+        atlas->runs[i] = NULL;
+    }
+}
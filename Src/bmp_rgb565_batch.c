@@ -0,0 +1,498 @@
+#include "bmp_rgb565_batch.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Private type */
+#ifdef BMP_565_BATCH_PTHREAD
+typedef struct
+{
+    uint8_t*               pbmp;
+    const BMP_565_CmdList* list;
+    uint32_t               first;
+    pthread_t              thread;
+} Worker_arg;
+#endif
+
+/* Private function prototypes */
+static BMP_565_Cmd* Push_cmd(BMP_565_CmdList* list, uint8_t type);
+static int32_t Band_range(const BMP_565_Cmd* cmd, uint32_t height, uint32_t* b0, uint32_t* b1);
+static void Line_step_to(const BMP_565_Cmd* cmd, int32_t row, int32_t* x, int32_t* y, int32_t* err);
+static void Exec_cmd(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height, const BMP_565_Cmd* cmd, int32_t by0, int32_t by1, int32_t line_x, int32_t line_err);
+#ifdef BMP_565_BATCH_PTHREAD
+static void* Worker(void* arg);
+#endif
+static void Exec_fill(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height, const BMP_565_Cmd* cmd, int32_t by0, int32_t by1);
+static void Exec_line(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height, const BMP_565_Cmd* cmd, int32_t by0, int32_t by1, int32_t x, int32_t err);
+static void Exec_blit(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height, const BMP_565_Cmd* cmd, int32_t by0, int32_t by1);
+static void Exec_text(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height, const BMP_565_Cmd* cmd, int32_t by0, int32_t by1);
+static inline uint16_t* Row_addr(uint8_t* pbase, uint32_t bytes_per_row, uint32_t height, int32_t y);
+
+
+// "bins" holds the per-band command lists: a command takes one entry for every
+// band it touches. NULL (or too small) makes every band scan the whole list.
+void BMP_565_CmdListInit(BMP_565_CmdList* list, BMP_565_Cmd* buf, uint32_t max, BMP_565_CmdBin* bins, uint32_t bins_max)
+{
+    list->cmds       = buf;
+    list->count      = 0;
+    list->max        = max;
+    list->bins       = bins;
+    list->bins_max   = bins_max;
+    list->bin_height = 0;
+}
+
+
+void BMP_565_CmdListClear(BMP_565_CmdList* list)
+{
+    list->count      = 0;
+    list->bin_height = 0;
+}
+
+
+/* Recording: each function returns 0, or -1 when the list is full */
+int32_t BMP_565_CmdFill(BMP_565_CmdList* list, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+        uint8_t r, uint8_t g, uint8_t b)
+{
+    BMP_565_Cmd* cmd = Push_cmd(list, BMP_565_CMD_FILL);
+    if (cmd == NULL)
+        return -1;
+
+    cmd->col   = COL_RGB565(r, g, b);
+    cmd->x0    = cmd->x_min = x0 < x1 ? x0 : x1;
+    cmd->x1    = cmd->x_max = x0 < x1 ? x1 : x0;
+    cmd->y0    = cmd->y_min = y0 < y1 ? y0 : y1;
+    cmd->y1    = cmd->y_max = y0 < y1 ? y1 : y0;
+    return 0;
+}
+
+
+int32_t BMP_565_CmdLine(BMP_565_CmdList* list, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+        uint8_t r, uint8_t g, uint8_t b)
+{
+    BMP_565_Cmd* cmd = Push_cmd(list, BMP_565_CMD_LINE);
+    if (cmd == NULL)
+        return -1;
+
+    // Store top to bottom, so a band can stop stepping once it has passed its last row
+    if (y1 < y0)
+    {
+        int32_t swap;
+        swap = x0; x0 = x1; x1 = swap;
+        swap = y0; y0 = y1; y1 = swap;
+    }
+
+    cmd->col   = COL_RGB565(r, g, b);
+    cmd->x0    = x0;
+    cmd->y0    = y0;
+    cmd->x1    = x1;
+    cmd->y1    = y1;
+    cmd->x_min = x0 < x1 ? x0 : x1;
+    cmd->x_max = x0 < x1 ? x1 : x0;
+    cmd->y_min = y0;
+    cmd->y_max = y1;
+    return 0;
+}
+
+
+int32_t BMP_565_CmdBlit(BMP_565_CmdList* list, int32_t x, int32_t y, uint8_t* pbmp_Src)
+{
+    if (pbmp_Src == NULL)
+        return -1;
+
+    BMP_565_Cmd* cmd = Push_cmd(list, BMP_565_CMD_BLIT);
+    if (cmd == NULL)
+        return -1;
+
+    cmd->psrc  = pbmp_Src;
+    cmd->x0    = cmd->x_min = x;
+    cmd->y0    = cmd->y_min = y;
+    cmd->x_max = x + (int32_t)BMP_565_GetWidth (pbmp_Src) - 1;
+    cmd->y_max = y + (int32_t)BMP_565_GetHeight(pbmp_Src) - 1;
+    return 0;
+}
+
+
+// Single line of text, foreground pixels only. "str" must stay valid until the list is executed.
+int32_t BMP_565_CmdText(BMP_565_CmdList* list, int32_t x, int32_t y, const char* str, const BMP_565_Font* font,
+        uint8_t r, uint8_t g, uint8_t b)
+{
+    if (str == NULL || font == NULL || font->p == NULL || font->char_width <= 0)
+        return -1;
+
+    BMP_565_Cmd* cmd = Push_cmd(list, BMP_565_CMD_TEXT);
+    if (cmd == NULL)
+        return -1;
+
+    cmd->col   = COL_RGB565(r, g, b);
+    cmd->str   = str;
+    cmd->font  = font;
+    cmd->x0    = cmd->x_min = x;
+    cmd->y0    = cmd->y_min = y;
+    cmd->x_max = x + (int32_t)strlen(str) * font->char_width - 1;
+    cmd->y_max = y + font->char_height - 1;
+    return 0;
+}
+
+
+uint32_t BMP_565_CmdListBands(uint8_t* pbmp)
+{
+    return (BMP_565_GetHeight(pbmp) + BMP_565_BATCH_BAND_ROWS - 1) >> BMP_565_BATCH_BAND_SHIFT;
+}
+
+
+// Sort the commands into bands for an image of the height of "pbmp", keeping
+// their order within each band. Recording a command drops the bins; Execute
+// rebuilds them. Returns 0, or -1 if the image has more than
+// BMP_565_BATCH_MAX_BANDS bands or the bin array is too small.
+int32_t BMP_565_CmdListBin(BMP_565_CmdList* list, uint8_t* pbmp)
+{
+    if (list == NULL)
+        return -1;
+    list->bin_height = 0;
+    if (pbmp == NULL || list->bins == NULL)
+        return -1;
+
+    uint32_t height = BMP_565_GetHeight(pbmp);
+    uint32_t bands  = BMP_565_CmdListBands(pbmp);
+    uint32_t b0, b1;
+    uint32_t pos[BMP_565_BATCH_MAX_BANDS];
+
+    if (bands > BMP_565_BATCH_MAX_BANDS)
+        return -1;
+
+    // Count the entries of every band, then turn the counts into start offsets
+    memset(list->bin_start, 0, sizeof(list->bin_start));
+    for (uint32_t i = 0; i < list->count; i++)
+    {
+        if (Band_range(&list->cmds[i], height, &b0, &b1) != 0)
+            continue;
+        for (uint32_t b = b0; b <= b1; b++)
+            list->bin_start[b + 1]++;
+    }
+    for (uint32_t b = 0; b < bands; b++)
+        list->bin_start[b + 1] += list->bin_start[b];
+    if (list->bin_start[bands] > list->bins_max)
+        return -1;
+
+    memcpy(pos, list->bin_start, bands * sizeof(uint32_t));
+    for (uint32_t i = 0; i < list->count; i++)
+    {
+        const BMP_565_Cmd* cmd = &list->cmds[i];
+        if (Band_range(cmd, height, &b0, &b1) != 0)
+            continue;
+
+        // A line is stepped once, top to bottom, recording where it enters each band
+        int32_t x = cmd->x0, y = cmd->y0;
+        int32_t err = 0;
+        if (cmd->type == BMP_565_CMD_LINE)
+            Line_step_to(cmd, cmd->y0, &x, &y, &err);
+
+        for (uint32_t b = b0; b <= b1; b++)
+        {
+            BMP_565_CmdBin* bin = &list->bins[pos[b]++];
+            if (cmd->type == BMP_565_CMD_LINE)
+                Line_step_to(cmd, (int32_t)(b << BMP_565_BATCH_BAND_SHIFT), &x, &y, &err);
+            bin->cmd = i;
+            bin->x   = x;
+            bin->err = err;
+        }
+    }
+
+    list->bin_height = height;
+    return 0;
+}
+
+
+// Replay every command that touches "band", clipped to the rows of that band.
+// Bands never share destination rows, so they may be replayed by different
+// threads. Without bins for this image every command is tested against the band.
+// An attached hash table is not updated here; see BMP_565_CmdListExecute().
+void BMP_565_CmdListExecuteBand(uint8_t* pbmp, const BMP_565_CmdList* list, uint32_t band)
+{
+    if (pbmp == NULL || list == NULL)
+        return;
+
+    uint32_t width  = BMP_565_GetWidth (pbmp);
+    uint32_t height = BMP_565_GetHeight (pbmp);
+    uint32_t bytes_per_row = BMP_565_GetBytesPerRow(pbmp);
+    uint8_t* pbase  = BMP_565_GetRowAddr(pbmp, height - 1);
+
+    int32_t by0 = (int32_t)(band << BMP_565_BATCH_BAND_SHIFT);
+    int32_t by1 = by0 + BMP_565_BATCH_BAND_ROWS - 1;
+    if (by0 >= (int32_t)height)
+        return;
+    if (by1 >= (int32_t)height)
+        by1 = height - 1;
+
+    if (list->bin_height == height)
+    {
+        for (uint32_t i = list->bin_start[band]; i < list->bin_start[band + 1]; i++)
+        {
+            const BMP_565_CmdBin* bin = &list->bins[i];
+            Exec_cmd(pbase, bytes_per_row, width, height, &list->cmds[bin->cmd], by0, by1, bin->x, bin->err);
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < list->count; i++)
+    {
+        const BMP_565_Cmd* cmd = &list->cmds[i];
+
+        // Not in this band
+        if (cmd->y_max < by0 || cmd->y_min > by1)
+            continue;
+
+        int32_t x = cmd->x0, y = cmd->y0;
+        int32_t err = 0;
+        if (cmd->type == BMP_565_CMD_LINE)
+        {
+            Line_step_to(cmd, cmd->y0, &x, &y, &err);
+            Line_step_to(cmd, by0, &x, &y, &err);
+        }
+        Exec_cmd(pbase, bytes_per_row, width, height, cmd, by0, by1, x, err);
+    }
+}
+
+
+// Replay the list band by band (top to bottom), so each band of the
+// destination stays in the D-cache while all of its commands are drawn.
+// The list is binned first; a host build with BMP_565_BATCH_PTHREAD hands the
+// bands to BMP_565_BATCH_THREADS worker threads.
+void BMP_565_CmdListExecute(uint8_t* pbmp, BMP_565_CmdList* list)
+{
+    if (pbmp == NULL || list == NULL)
+        return;
+
+    if (list->bin_height != BMP_565_GetHeight(pbmp))
+        BMP_565_CmdListBin(list, pbmp);
+
+#ifdef BMP_565_BATCH_PTHREAD
+    Worker_arg arg[BMP_565_BATCH_THREADS];
+    uint8_t    started[BMP_565_BATCH_THREADS];
+
+    for (uint32_t t = 0; t < BMP_565_BATCH_THREADS; t++)
+    {
+        arg[t].pbmp  = pbmp;
+        arg[t].list  = list;
+        arg[t].first = t;
+        started[t] = pthread_create(&arg[t].thread, NULL, Worker, &arg[t]) == 0;
+        if (!started[t])
+            Worker(&arg[t]);
+    }
+    for (uint32_t t = 0; t < BMP_565_BATCH_THREADS; t++)
+    {
+        if (started[t])
+            pthread_join(arg[t].thread, NULL);
+    }
+#else
+    uint32_t bands = BMP_565_CmdListBands(pbmp);
+    for (uint32_t band = 0; band < bands; band++)
+        BMP_565_CmdListExecuteBand(pbmp, list, band);
+#endif
+
+    for (uint32_t i = 0; i < list->count; i++)
+    {
+        const BMP_565_Cmd* cmd = &list->cmds[i];
+        if (cmd->x_max < 0 || cmd->y_max < 0)
+            continue;
+        BMP_565_HashInvalidate(pbmp, cmd->x_min > 0 ? cmd->x_min : 0, cmd->y_min > 0 ? cmd->y_min : 0,
+                cmd->x_max, cmd->y_max);
+    }
+}
+
+
+/*********************************** Private methods **********************************/
+
+static BMP_565_Cmd* Push_cmd(BMP_565_CmdList* list, uint8_t type)
+{
+    if (list == NULL || list->count >= list->max)
+        return NULL;
+
+    BMP_565_Cmd* cmd = &list->cmds[list->count++];
+    memset(cmd, 0, sizeof(BMP_565_Cmd));
+    cmd->type = type;
+    list->bin_height = 0;
+    return cmd;
+}
+
+// Bands touched by the command inside an image of "height" rows; -1 if none
+static int32_t Band_range(const BMP_565_Cmd* cmd, uint32_t height, uint32_t* b0, uint32_t* b1)
+{
+    if (cmd->y_max < 0 || cmd->y_min >= (int32_t)height || cmd->y_min > cmd->y_max)
+        return -1;
+
+    *b0 = (uint32_t)(cmd->y_min > 0 ? cmd->y_min : 0) >> BMP_565_BATCH_BAND_SHIFT;
+    *b1 = (uint32_t)(cmd->y_max < (int32_t)height - 1 ? cmd->y_max : (int32_t)height - 1) >> BMP_565_BATCH_BAND_SHIFT;
+    return 0;
+}
+
+// Bresenham, same stepping as BMP_565_DrawLineRGB(). Starting at row cmd->y0
+// (*x = cmd->x0, *y = cmd->y0) this sets up the error term; otherwise it steps
+// on until the line reaches "row", which must not be past cmd->y1.
+static void Line_step_to(const BMP_565_Cmd* cmd, int32_t row, int32_t* x, int32_t* y, int32_t* err)
+{
+    int32_t dx = cmd->x1 - cmd->x0 > 0 ? cmd->x1 - cmd->x0 : cmd->x0 - cmd->x1;
+    int32_t sx = cmd->x0 < cmd->x1 ? 1 : -1;
+    int32_t dy = cmd->y1 - cmd->y0;
+    int32_t e2;
+
+    if (row <= cmd->y0)
+    {
+        *err = dx - dy;
+        return;
+    }
+
+    while (*y < row)
+    {
+        e2 = 2 * *err;
+        if (e2 > -dy) {*err -= dy;  *x += sx;}
+        if (e2 <  dx) {*err += dx;  *y += 1;}
+    }
+}
+
+static void Exec_cmd(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height,
+        const BMP_565_Cmd* cmd, int32_t by0, int32_t by1, int32_t line_x, int32_t line_err)
+{
+    switch (cmd->type)
+    {
+    case BMP_565_CMD_FILL:
+        Exec_fill(pbase, bytes_per_row, width, height, cmd, by0, by1);
+        break;
+    case BMP_565_CMD_LINE:
+        Exec_line(pbase, bytes_per_row, width, height, cmd, by0, by1, line_x, line_err);
+        break;
+    case BMP_565_CMD_BLIT:
+        Exec_blit(pbase, bytes_per_row, width, height, cmd, by0, by1);
+        break;
+    case BMP_565_CMD_TEXT:
+        Exec_text(pbase, bytes_per_row, width, height, cmd, by0, by1);
+        break;
+    default:
+        break;
+    }
+}
+
+#ifdef BMP_565_BATCH_PTHREAD
+// Bands are dealt out round-robin, so a thread never waits on a crowded part of the image
+static void* Worker(void* arg)
+{
+    Worker_arg* w = arg;
+    uint32_t bands = BMP_565_CmdListBands(w->pbmp);
+
+    for (uint32_t band = w->first; band < bands; band += BMP_565_BATCH_THREADS)
+        BMP_565_CmdListExecuteBand(w->pbmp, w->list, band);
+    return NULL;
+}
+#endif
+
+static inline uint16_t* Row_addr(uint8_t* pbase, uint32_t bytes_per_row, uint32_t height, int32_t y)
+{
+    return (uint16_t*)(pbase + bytes_per_row * (height - y - 1));
+}
+
+static void Exec_fill(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height,
+        const BMP_565_Cmd* cmd, int32_t by0, int32_t by1)
+{
+    int32_t x0 = cmd->x0 > 0 ? cmd->x0 : 0;
+    int32_t x1 = cmd->x1 < (int32_t)width - 1 ? cmd->x1 : (int32_t)width - 1;
+    int32_t y0 = cmd->y0 > by0 ? cmd->y0 : by0;
+    int32_t y1 = cmd->y1 < by1 ? cmd->y1 : by1;
+
+    if (x0 > x1)
+        return;
+
+    for (int32_t y = y0; y <= y1; y++)
+    {
+        uint16_t* p = Row_addr(pbase, bytes_per_row, height, y) + x0;
+        for (int32_t x = x0; x <= x1; x++)
+            *p++ = cmd->col;
+    }
+}
+
+// Continues the line from (x, first row of the band) with error term "err", see Line_step_to()
+static void Exec_line(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height,
+        const BMP_565_Cmd* cmd, int32_t by0, int32_t by1, int32_t x, int32_t err)
+{
+    int32_t x0 = x, y0 = cmd->y0 > by0 ? cmd->y0 : by0;
+    int32_t x1 = cmd->x1, y1 = cmd->y1;
+
+    int32_t dx = x1 - cmd->x0 > 0 ? x1 - cmd->x0 : cmd->x0 - x1;
+    int32_t sx = cmd->x0 < x1 ? 1 : -1;
+    int32_t dy = y1 - cmd->y0;
+    int32_t e2;
+
+    for (;;)
+    {
+        if (y0 > by1)
+            break;
+        if (y0 >= by0 && x0 >= 0 && x0 < (int32_t)width)
+            *(Row_addr(pbase, bytes_per_row, height, y0) + x0) = cmd->col;
+
+        if (x0 == x1 && y0 == y1)
+            break;
+
+        e2 = 2*err;
+        if (e2 > -dy) {err -= dy;   x0 += sx;}
+        if (e2 <  dx) {err += dx;   y0 += 1;}
+    }
+}
+
+static void Exec_blit(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height,
+        const BMP_565_Cmd* cmd, int32_t by0, int32_t by1)
+{
+    uint8_t* psrc = cmd->psrc;
+    int32_t  src_w = (int32_t)BMP_565_GetWidth (psrc);
+
+    int32_t x0 = cmd->x_min > 0 ? cmd->x_min : 0;
+    int32_t x1 = cmd->x_max < (int32_t)width - 1 ? cmd->x_max : (int32_t)width - 1;
+    int32_t y0 = cmd->y_min > by0 ? cmd->y_min : by0;
+    int32_t y1 = cmd->y_max < by1 ? cmd->y_max : by1;
+
+    if (x0 > x1 || src_w <= 0)
+        return;
+
+    for (int32_t y = y0; y <= y1; y++)
+    {
+        uint8_t* ps = BMP_565_GetRowAddr(psrc, y - cmd->y_min) + ((x0 - cmd->x_min) << 1);
+        memcpy(Row_addr(pbase, bytes_per_row, height, y) + x0, ps, (x1 - x0 + 1) << 1);
+    }
+}
+
+static void Exec_text(uint8_t* pbase, uint32_t bytes_per_row, uint32_t width, uint32_t height,
+        const BMP_565_Cmd* cmd, int32_t by0, int32_t by1)
+{
+    const BMP_565_Font* font = cmd->font;
+    int32_t  cw = font->char_width;
+    int32_t  ch = font->char_height;
+    uint32_t bn = (cw + 7) >> 3;
+
+    int32_t y0 = cmd->y_min > by0 ? cmd->y_min : by0;
+    int32_t y1 = cmd->y_max < by1 ? cmd->y_max : by1;
+
+    int32_t xp = cmd->x0;
+    for (const char* s = cmd->str; *s != 0; s++, xp += cw)
+    {
+        if (xp >= (int32_t)width)
+            break;
+        if (xp + cw <= 0)
+            continue;
+
+        const uint8_t* glyph = font->p + (uint32_t)(uint8_t)*s * ch * bn;
+        for (int32_t y = y0; y <= y1; y++)
+        {
+            const uint8_t* pg = glyph + (y - cmd->y0) * bn;
+            uint16_t* pd = Row_addr(pbase, bytes_per_row, height, y);
+
+            for (int32_t i = 0; i < cw; i++)
+            {
+                int32_t x = xp + i;
+                if ((pg[i >> 3] >> (i & 7)) & 0x01)
+                {
+                    if (x >= 0 && x < (int32_t)width)
+                        pd[x] = cmd->col;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,198 @@
+#include "bmp_rgb565_diff.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Private function prototypes */
+static inline uint32_t Span_differs(const uint8_t* pA, const uint8_t* pB, uint32_t bytes);
+static inline int64_t  Merge_cost(const BMP_565_Rect* r0, const BMP_565_Rect* r1);
+static inline void     Merge_rect(BMP_565_Rect* pDst, const BMP_565_Rect* pSrc);
+static void     Add_rect(BMP_565_Rect* rects, uint32_t* count, uint32_t max, const BMP_565_Rect* r, uint32_t merge_cost);
+static uint32_t Coalesce_rects(BMP_565_Rect* rects, uint32_t count, uint32_t merge_cost);
+
+
+uint32_t BMP_565_Diff(uint8_t* pbmp_A, uint8_t* pbmp_B, BMP_565_Rect* out_rects, uint32_t max)
+{
+    return BMP_565_DiffEx(pbmp_A, pbmp_B, out_rects, max, BMP_565_DIFF_MERGE_COST);
+}
+
+
+// Compare two images of the same size tile by tile and return the number of
+// rectangles written to "out_rects". Every changed pixel is covered by at least
+// one rectangle; neighbouring changed tiles are merged while the merge pulls in
+// no more than "merge_cost" unchanged pixels. When "max" is reached the new
+// region is merged into the cheapest existing rectangle instead of being dropped.
+uint32_t BMP_565_DiffEx(uint8_t* pbmp_A, uint8_t* pbmp_B, BMP_565_Rect* out_rects, uint32_t max, uint32_t merge_cost)
+{
+    if (pbmp_A == NULL || pbmp_B == NULL || out_rects == NULL || max == 0)
+        return 0;
+
+    uint32_t width  = BMP_565_GetWidth (pbmp_A);
+    uint32_t height = BMP_565_GetHeight (pbmp_A);
+
+    if (width != BMP_565_GetWidth(pbmp_B) || height != BMP_565_GetHeight(pbmp_B) || width == 0 || height == 0)
+        return 0;
+
+    uint32_t bytes_per_row = BMP_565_GetBytesPerRow(pbmp_A);
+
+    // Lowest address row (= bottom image row)
+    uint8_t* pbase_A = BMP_565_GetRowAddr(pbmp_A, height - 1);
+    uint8_t* pbase_B = BMP_565_GetRowAddr(pbmp_B, height - 1);
+
+    uint32_t count = 0;
+    BMP_565_Rect run;
+
+    for (uint32_t ty = 0; ty < height; ty += BMP_565_DIFF_TILE)
+    {
+        uint32_t y_end  = (ty + BMP_565_DIFF_TILE < height ? ty + BMP_565_DIFF_TILE : height) - 1;
+        uint32_t in_run = 0;
+
+        for (uint32_t tx = 0; tx < width; tx += BMP_565_DIFF_TILE)
+        {
+            uint32_t x_end   = (tx + BMP_565_DIFF_TILE < width ? tx + BMP_565_DIFF_TILE : width) - 1;
+            uint32_t bytes   = (x_end - tx + 1) << 1;
+            uint32_t changed = 0;
+
+            // A 16 px tile row is 32 bytes, but only 2-byte aligned (pixels start at offset 70):
+            // it usually straddles two D-cache lines
+            for (uint32_t y = ty; y <= y_end && !changed; y++)
+            {
+                uint32_t offset = bytes_per_row * (height - y - 1) + (tx << 1);
+                changed = Span_differs(pbase_A + offset, pbase_B + offset, bytes);
+            }
+
+            if (changed && !in_run)
+            {
+                run.x0 = tx;
+                run.y0 = ty;
+                run.y1 = y_end;
+                in_run = 1;
+            }
+            else if (!changed && in_run)
+            {
+                run.x1 = tx - 1;
+                Add_rect(out_rects, &count, max, &run, merge_cost);
+                in_run = 0;
+            }
+        }
+
+        if (in_run)
+        {
+            run.x1 = width - 1;
+            Add_rect(out_rects, &count, max, &run, merge_cost);
+        }
+    }
+
+    return Coalesce_rects(out_rects, count, merge_cost);
+}
+
+
+/*********************************** Private methods **********************************/
+
+// Pixel data starts at an offset of 70 bytes, so rows are only 16-bit aligned.
+// memcpy() into a word lets the compiler emit plain (unaligned) LDRs on the M7.
+static inline uint32_t Span_differs(const uint8_t* pA, const uint8_t* pB, uint32_t bytes)
+{
+    uint32_t a0, a1, b0, b1;
+
+    while (bytes >= 8)
+    {
+        memcpy(&a0, pA    , 4);
+        memcpy(&a1, pA + 4, 4);
+        memcpy(&b0, pB    , 4);
+        memcpy(&b1, pB + 4, 4);
+        if ((a0 ^ b0) | (a1 ^ b1))
+            return 1;
+        pA += 8;
+        pB += 8;
+        bytes -= 8;
+    }
+    if (bytes >= 4)
+    {
+        memcpy(&a0, pA, 4);
+        memcpy(&b0, pB, 4);
+        if (a0 != b0)
+            return 1;
+        pA += 4;
+        pB += 4;
+        bytes -= 4;
+    }
+    if (bytes)
+        return (pA[0] != pB[0]) || (pA[1] != pB[1]);
+
+    return 0;
+}
+
+// Number of pixels the bounding box of both rectangles adds on top of their own areas
+static inline int64_t Merge_cost(const BMP_565_Rect* r0, const BMP_565_Rect* r1)
+{
+    uint32_t x0 = r0->x0 < r1->x0 ? r0->x0 : r1->x0;
+    uint32_t y0 = r0->y0 < r1->y0 ? r0->y0 : r1->y0;
+    uint32_t x1 = r0->x1 > r1->x1 ? r0->x1 : r1->x1;
+    uint32_t y1 = r0->y1 > r1->y1 ? r0->y1 : r1->y1;
+
+    int64_t area_u = (int64_t)(x1 - x0 + 1) * (y1 - y0 + 1);
+    int64_t area_0 = (int64_t)(r0->x1 - r0->x0 + 1) * (r0->y1 - r0->y0 + 1);
+    int64_t area_1 = (int64_t)(r1->x1 - r1->x0 + 1) * (r1->y1 - r1->y0 + 1);
+
+    int64_t cost = area_u - area_0 - area_1;
+    return cost > 0 ? cost : 0;
+}
+
+static inline void Merge_rect(BMP_565_Rect* pDst, const BMP_565_Rect* pSrc)
+{
+    if (pSrc->x0 < pDst->x0) pDst->x0 = pSrc->x0;
+    if (pSrc->y0 < pDst->y0) pDst->y0 = pSrc->y0;
+    if (pSrc->x1 > pDst->x1) pDst->x1 = pSrc->x1;
+    if (pSrc->y1 > pDst->y1) pDst->y1 = pSrc->y1;
+}
+
+static void Add_rect(BMP_565_Rect* rects, uint32_t* count, uint32_t max, const BMP_565_Rect* r, uint32_t merge_cost)
+{
+    uint32_t best = 0;
+    int64_t  best_cost = -1;
+
+    for (uint32_t i = 0; i < *count; i++)
+    {
+        int64_t cost = Merge_cost(&rects[i], r);
+        if (best_cost < 0 || cost < best_cost)
+        {
+            best_cost = cost;
+            best = i;
+        }
+    }
+
+    if (best_cost >= 0 && (best_cost <= merge_cost || *count >= max))
+    {
+        Merge_rect(&rects[best], r);
+        return;
+    }
+
+    rects[(*count)++] = *r;
+}
+
+// Repeat pairwise merging until no pair is cheaper than "merge_cost"
+static uint32_t Coalesce_rects(BMP_565_Rect* rects, uint32_t count, uint32_t merge_cost)
+{
+    uint32_t merged = 1;
+
+    while (merged)
+    {
+        merged = 0;
+        for (uint32_t i = 0; i < count && !merged; i++)
+        {
+            for (uint32_t j = i + 1; j < count; j++)
+            {
+                if (Merge_cost(&rects[i], &rects[j]) <= merge_cost)
+                {
+                    Merge_rect(&rects[i], &rects[j]);
+                    rects[j] = rects[--count];
+                    merged = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    return count;
+}
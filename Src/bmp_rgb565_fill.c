@@ -0,0 +1,129 @@
+#include "bmp_rgb565_fill.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+
+
+/* Private type */
+typedef struct
+{
+    BMP_565_FillSpan*   stack;
+    uint32_t            size;
+    uint32_t            sp;
+    uint32_t            overflow;
+    int32_t             height;
+} SpanStack;
+
+/* Private function prototypes */
+static inline void Push(SpanStack* s, int32_t y, int32_t xl, int32_t xr, int32_t dy);
+
+
+// Fill the 4-connected area of the colour found at (x, y) with (r, g, b).
+// Uses the span algorithm (Heckbert, Graphics Gems I): one stack entry per
+// horizontal run, so memory is bounded by "stack_size" entries supplied by the
+// caller and nothing is recursive. 64 entries are plenty for UI-sized shapes.
+// Returns the number of pixels filled, or -1 if the stack overflowed and part
+// of the area may have been left unfilled.
+int32_t BMP_565_FloodFillRGB(uint8_t* pbmp, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b,
+        BMP_565_FillSpan* stack, uint32_t stack_size)
+{
+    if (pbmp == NULL || stack == NULL || stack_size == 0)
+        return -1;
+
+    int32_t width  = (int32_t)BMP_565_GetWidth (pbmp);
+    int32_t height = (int32_t)BMP_565_GetHeight(pbmp);
+    if (x >= (uint32_t)width || y >= (uint32_t)height)
+        return 0;
+
+    uint32_t stride = BMP_565_GetBytesPerRow(pbmp);
+    uint8_t* pdata  = BMP_565_GetRowAddr(pbmp, height - 1);     // lowest address = bottom row
+    uint16_t col    = COL_RGB565(r, g, b);
+    uint16_t old    = ((uint16_t*)BMP_565_GetRowAddr(pbmp, y))[x];
+    if (old == col)
+        return 0;
+
+    SpanStack s = { stack, stack_size, 0, 0, height };
+    int32_t filled = 0;
+    int32_t min_x = width, min_y = height, max_x = -1, max_y = -1;
+
+    Push(&s, y,     x, x, -1);
+    Push(&s, y + 1, x, x,  1);
+
+    while (s.sp > 0)
+    {
+        BMP_565_FillSpan* sp = &s.stack[--s.sp];
+        int32_t cy = sp->y, x1 = sp->xl, x2 = sp->xr, dy = sp->dy;
+        uint16_t* prow = (uint16_t*)(pdata + stride * (height - 1 - cy));
+        int32_t cx, l;
+
+        // Extend left from x1
+        for (cx = x1; cx >= 0 && prow[cx] == old; cx--)
+            prow[cx] = col;
+        filled += x1 - cx;
+
+        if (cx < x1)
+        {
+            l = cx + 1;
+            if (l < x1)
+                Push(&s, cy - dy, l, x1 - 1, -dy);      // leaked past the parent's left edge
+            cx = x1 + 1;
+        }
+        else
+        {
+            // x1 itself was not fillable: skip to the next fillable pixel under the parent span
+            for (cx = x1 + 1; cx <= x2 && prow[cx] != old; cx++)
+                ;
+            if (cx > x2)
+                continue;
+            l = cx;
+        }
+
+        do
+        {
+            int32_t start = cx;
+            for (; cx < width && prow[cx] == old; cx++)
+                prow[cx] = col;
+            filled += cx - start;
+
+            if (l < cx)
+            {
+                if (l     < min_x) min_x = l;
+                if (cx - 1 > max_x) max_x = cx - 1;
+                if (cy    < min_y) min_y = cy;
+                if (cy    > max_y) max_y = cy;
+            }
+
+            Push(&s, cy + dy, l, cx - 1, dy);
+            if (cx > x2 + 1)
+                Push(&s, cy - dy, x2 + 1, cx - 1, -dy);  // leaked past the parent's right edge
+
+            for (cx++; cx <= x2 && prow[cx] != old; cx++)
+                ;
+            l = cx;
+        } while (cx <= x2);
+    }
+
+    if (max_x >= 0)
+        BMP_565_HashInvalidate(pbmp, min_x, min_y, max_x, max_y);
+
+    return s.overflow ? -1 : filled;
+}
+
+
+/*********************************** Private methods **********************************/
+
+static inline void Push(SpanStack* s, int32_t y, int32_t xl, int32_t xr, int32_t dy)
+{
+    if (y < 0 || y >= s->height || xl > xr)
+        return;
+    if (s->sp == s->size)
+    {
+        s->overflow = 1;
+        return;
+    }
+
+    BMP_565_FillSpan* sp = &s->stack[s->sp++];
+    sp->y  = (int16_t)y;
+    sp->xl = (int16_t)xl;
+    sp->xr = (int16_t)xr;
+    sp->dy = (int16_t)dy;
+}
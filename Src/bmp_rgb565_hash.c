@@ -0,0 +1,268 @@
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+#define HASH_PRIME1     0x9E3779B1UL
+#define HASH_PRIME2     0x85EBCA77UL
+#define HASH_PRIME3     0xC2B2AE3DUL
+
+typedef struct
+{
+    uint8_t*  pbmp;
+    uint32_t  tiles_x;
+    uint32_t  tiles_y;
+    uint32_t* hash;         // tiles_x * tiles_y entries
+    uint32_t* dirty;        // one bit per tile
+} TileHash;
+
+static TileHash HashSlot[BMP_565_HASH_SLOTS];
+
+/* Private function prototypes */
+static inline TileHash* Get_slot(uint8_t* pbmp);
+static inline uint32_t  Rotl(uint32_t v, uint32_t s);
+static uint32_t Hash_tile(TileHash* th, uint32_t tile);
+static void     Refresh_all(TileHash* th);
+
+
+// Attach a hash table to an image. All tiles start dirty, so the first query
+// hashes the whole image. Returns 0 on success, -1 if no slot or memory is left.
+int32_t BMP_565_HashAttach(uint8_t* pbmp)
+{
+    if (pbmp == NULL)
+        return -1;
+    if (Get_slot(pbmp) != NULL)
+        return 0;
+
+    uint32_t slot;
+    for (slot = 0; slot < BMP_565_HASH_SLOTS; slot++)
+    {
+        if (HashSlot[slot].pbmp == NULL)
+            break;
+    }
+    if (slot == BMP_565_HASH_SLOTS)
+        return -1;
+
+    TileHash* th = &HashSlot[slot];
+    th->tiles_x = (BMP_565_GetWidth (pbmp) + BMP_565_HASH_TILE - 1) >> BMP_565_HASH_TILE_SHIFT;
+    th->tiles_y = (BMP_565_GetHeight(pbmp) + BMP_565_HASH_TILE - 1) >> BMP_565_HASH_TILE_SHIFT;
+
+    uint32_t tiles = th->tiles_x * th->tiles_y;
+    uint32_t dirty_words = (tiles + 31) >> 5;
+
+    /* Hash values and dirty bits share one allocation */
+    th->hash = malloc((tiles + dirty_words) * sizeof(uint32_t));
+    if (th->hash == NULL)
+        return -1;
+    th->dirty = th->hash + tiles;
+    memset(th->dirty, 0xFF, dirty_words * sizeof(uint32_t));
+
+    th->pbmp = pbmp;
+    return 0;
+}
+
+
+void BMP_565_HashDetach(uint8_t* pbmp)
+{
+    TileHash* th = Get_slot(pbmp);
+    if (th == NULL)
+        return;
+
+    free(th->hash);
+    memset(th, 0, sizeof(TileHash));
+}
+
+
+// Mark every tile touched by the inclusive rectangle as dirty.
+// Called by the drawing functions; call it after writing pixel data directly.
+void BMP_565_HashInvalidate(uint8_t* pbmp, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    TileHash* th = Get_slot(pbmp);
+    if (th == NULL)
+        return;
+
+    uint32_t tx0 = x0 >> BMP_565_HASH_TILE_SHIFT;
+    uint32_t ty0 = y0 >> BMP_565_HASH_TILE_SHIFT;
+    uint32_t tx1 = x1 >> BMP_565_HASH_TILE_SHIFT;
+    uint32_t ty1 = y1 >> BMP_565_HASH_TILE_SHIFT;
+
+    if (tx1 >= th->tiles_x) tx1 = th->tiles_x - 1;
+    if (ty1 >= th->tiles_y) ty1 = th->tiles_y - 1;
+
+    for (uint32_t ty = ty0; ty <= ty1; ty++)
+    {
+        for (uint32_t tx = tx0; tx <= tx1; tx++)
+        {
+            uint32_t tile = ty * th->tiles_x + tx;
+            th->dirty[tile >> 5] |= 1UL << (tile & 31);
+        }
+    }
+}
+
+
+uint32_t BMP_565_HashTileCount(uint8_t* pbmp)
+{
+    TileHash* th = Get_slot(pbmp);
+    if (th == NULL)
+        return 0;
+
+    return th->tiles_x * th->tiles_y;
+}
+
+
+// Tiles are numbered row-major from the top-left corner
+uint32_t BMP_565_HashGetTile(uint8_t* pbmp, uint32_t tile)
+{
+    TileHash* th = Get_slot(pbmp);
+    if (th == NULL || tile >= th->tiles_x * th->tiles_y)
+        return 0;
+
+    if (th->dirty[tile >> 5] & (1UL << (tile & 31)))
+    {
+        th->hash[tile] = Hash_tile(th, tile);
+        th->dirty[tile >> 5] &= ~(1UL << (tile & 31));
+    }
+    return th->hash[tile];
+}
+
+
+void BMP_565_HashGetTileRect(uint8_t* pbmp, uint32_t tile, BMP_565_Rect* rect)
+{
+    TileHash* th = Get_slot(pbmp);
+    if (th == NULL || rect == NULL || tile >= th->tiles_x * th->tiles_y)
+        return;
+
+    uint32_t width  = BMP_565_GetWidth (pbmp);
+    uint32_t height = BMP_565_GetHeight (pbmp);
+
+    rect->x0 = (tile % th->tiles_x) << BMP_565_HASH_TILE_SHIFT;
+    rect->y0 = (tile / th->tiles_x) << BMP_565_HASH_TILE_SHIFT;
+    rect->x1 = rect->x0 + BMP_565_HASH_TILE - 1;
+    rect->y1 = rect->y0 + BMP_565_HASH_TILE - 1;
+    if (rect->x1 >= width)  rect->x1 = width  - 1;
+    if (rect->y1 >= height) rect->y1 = height - 1;
+}
+
+
+// Copy all (refreshed) tile hashes to "snapshot", which must hold
+// BMP_565_HashTileCount() entries. Returns the number of entries written.
+uint32_t BMP_565_HashSnapshot(uint8_t* pbmp, uint32_t* snapshot)
+{
+    TileHash* th = Get_slot(pbmp);
+    if (th == NULL || snapshot == NULL)
+        return 0;
+
+    Refresh_all(th);
+
+    uint32_t tiles = th->tiles_x * th->tiles_y;
+    memcpy(snapshot, th->hash, tiles * sizeof(uint32_t));
+    return tiles;
+}
+
+
+// Write the indices of the tiles whose hash differs from "snapshot" to "out_tiles"
+// (up to "max" entries). Returns the total number of differing tiles.
+uint32_t BMP_565_HashDiff(uint8_t* pbmp, const uint32_t* snapshot, uint32_t* out_tiles, uint32_t max)
+{
+    TileHash* th = Get_slot(pbmp);
+    if (th == NULL || snapshot == NULL)
+        return 0;
+
+    Refresh_all(th);
+
+    uint32_t tiles = th->tiles_x * th->tiles_y;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < tiles; i++)
+    {
+        if (th->hash[i] != snapshot[i])
+        {
+            if (out_tiles != NULL && count < max)
+                out_tiles[count] = i;
+            count++;
+        }
+    }
+    return count;
+}
+
+
+/*********************************** Private methods **********************************/
+
+// Tables are found by image address: nothing is stored in the image itself,
+// so const images in flash, header copies and saved files are never affected
+static inline TileHash* Get_slot(uint8_t* pbmp)
+{
+    if (pbmp == NULL)
+        return NULL;
+
+    for (uint32_t i = 0; i < BMP_565_HASH_SLOTS; i++)
+    {
+        if (HashSlot[i].pbmp == pbmp)
+            return &HashSlot[i];
+    }
+    return NULL;
+}
+
+static inline uint32_t Rotl(uint32_t v, uint32_t s)
+{
+    return (v << s) | (v >> (32 - s));
+}
+
+// xxHash32-style word hash over the tile, row by row
+static uint32_t Hash_tile(TileHash* th, uint32_t tile)
+{
+    uint8_t* pbmp   = th->pbmp;
+    uint32_t width  = BMP_565_GetWidth (pbmp);
+    uint32_t height = BMP_565_GetHeight (pbmp);
+    uint32_t bytes_per_row = BMP_565_GetBytesPerRow(pbmp);
+    uint8_t* pbase  = BMP_565_GetRowAddr(pbmp, height - 1);
+
+    uint32_t x0 = (tile % th->tiles_x) << BMP_565_HASH_TILE_SHIFT;
+    uint32_t y0 = (tile / th->tiles_x) << BMP_565_HASH_TILE_SHIFT;
+    uint32_t x1 = x0 + BMP_565_HASH_TILE < width  ? x0 + BMP_565_HASH_TILE : width;
+    uint32_t y1 = y0 + BMP_565_HASH_TILE < height ? y0 + BMP_565_HASH_TILE : height;
+    uint32_t bytes = (x1 - x0) << 1;
+
+    uint32_t h = HASH_PRIME3 + tile;
+    uint32_t w;
+
+    for (uint32_t y = y0; y < y1; y++)
+    {
+        uint8_t* p = pbase + bytes_per_row * (height - y - 1) + (x0 << 1);
+        uint32_t n = bytes;
+
+        while (n >= 4)
+        {
+            memcpy(&w, p, 4);
+            h = Rotl(h + w * HASH_PRIME2, 13) * HASH_PRIME1;
+            p += 4;
+            n -= 4;
+        }
+        if (n)
+            h = Rotl(h + ((uint32_t)p[0] | ((uint32_t)p[1] << 8)) * HASH_PRIME2, 13) * HASH_PRIME1;
+    }
+
+    h ^= h >> 15;
+    h *= HASH_PRIME2;
+    h ^= h >> 13;
+    h *= HASH_PRIME3;
+    h ^= h >> 16;
+    return h;
+}
+
+static void Refresh_all(TileHash* th)
+{
+    uint32_t tiles = th->tiles_x * th->tiles_y;
+
+    for (uint32_t i = 0; i < tiles; i += 32)
+    {
+        uint32_t bits = th->dirty[i >> 5];
+        while (bits)
+        {
+            uint32_t b = __builtin_ctz(bits);
+            if (i + b < tiles)
+                th->hash[i + b] = Hash_tile(th, i + b);
+            bits &= bits - 1;
+        }
+        th->dirty[i >> 5] = 0;
+    }
+}
@@ -0,0 +1,130 @@
+#include "bmp_rgb565_lut.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <math.h>
+
+
+/* Private function prototypes */
+static float Eval_curve(const BMP_565_LutCurve* c, float v);
+static inline int32_t Clamp_255(int32_t v);
+
+
+// Channel mode: per-channel curves, NULL = identity for that channel.
+// Building costs 128 powf() calls; applying is three lookups and an OR per pixel.
+void BMP_565_LutInitCurve(BMP_565_Lut* lut, const BMP_565_LutCurve* r, const BMP_565_LutCurve* g, const BMP_565_LutCurve* b)
+{
+    lut->mode = BMP_565_LUT_CHANNEL;
+
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        lut->r[i] = (uint16_t)((uint32_t)(Eval_curve(r, i / 31.0f) * 31.0f + 0.5f) << 11);
+        lut->b[i] = (uint16_t) (uint32_t)(Eval_curve(b, i / 31.0f) * 31.0f + 0.5f);
+    }
+    for (uint32_t i = 0; i < 64; i++)
+        lut->g[i] = (uint16_t)((uint32_t)(Eval_curve(g, i / 63.0f) * 63.0f + 0.5f) << 5);
+}
+
+
+// Matrix mode: out = m * curve(in), "m" row-major with rows for R, G, B out,
+// coefficients within +/-8.
+// The curves and the matrix column of each input channel are folded into one
+// table, so a pixel is three lookups, three sums, a clamp and a pack.
+void BMP_565_LutInitMatrix(BMP_565_Lut* lut, const float m[9], const BMP_565_LutCurve* r, const BMP_565_LutCurve* g, const BMP_565_LutCurve* b)
+{
+    lut->mode = BMP_565_LUT_MATRIX;
+
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        float vr = Eval_curve(r, i / 31.0f) * 255.0f * 16.0f;
+        float vb = Eval_curve(b, i / 31.0f) * 255.0f * 16.0f;
+
+        lut->mix_r[i].r = (int16_t)lroundf(m[0] * vr);
+        lut->mix_r[i].g = (int16_t)lroundf(m[3] * vr);
+        lut->mix_r[i].b = (int16_t)lroundf(m[6] * vr);
+        lut->mix_b[i].r = (int16_t)lroundf(m[2] * vb);
+        lut->mix_b[i].g = (int16_t)lroundf(m[5] * vb);
+        lut->mix_b[i].b = (int16_t)lroundf(m[8] * vb);
+    }
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        float vg = Eval_curve(g, i / 63.0f) * 255.0f * 16.0f;
+
+        lut->mix_g[i].r = (int16_t)lroundf(m[1] * vg);
+        lut->mix_g[i].g = (int16_t)lroundf(m[4] * vg);
+        lut->mix_g[i].b = (int16_t)lroundf(m[7] * vg);
+    }
+}
+
+
+// "dst" may equal "src"
+void BMP_565_LutApplyRow(const BMP_565_Lut* lut, uint16_t* dst, const uint16_t* src, uint32_t count)
+{
+    if (lut->mode == BMP_565_LUT_CHANNEL)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint16_t c = src[i];
+            dst[i] = lut->r[c >> 11] | lut->g[(c >> 5) & 0x3F] | lut->b[c & 0x1F];
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint16_t c = src[i];
+        const BMP_565_LutMix* mr = &lut->mix_r[c >> 11];
+        const BMP_565_LutMix* mg = &lut->mix_g[(c >> 5) & 0x3F];
+        const BMP_565_LutMix* mb = &lut->mix_b[c & 0x1F];
+
+        int32_t r = Clamp_255((mr->r + mg->r + mb->r + 8) >> 4);
+        int32_t g = Clamp_255((mr->g + mg->g + mb->g + 8) >> 4);
+        int32_t b = Clamp_255((mr->b + mg->b + mb->b + 8) >> 4);
+        dst[i] = COL_RGB565(r, g, b);
+    }
+}
+
+
+// Apply in place to "rect" (NULL = whole image), e.g. only the region that was redrawn
+void BMP_565_LutApply(uint8_t* pbmp, const BMP_565_Lut* lut, const BMP_565_Rect* rect)
+{
+    if (pbmp == NULL || lut == NULL)
+        return;
+
+    uint32_t width  = BMP_565_GetWidth (pbmp);
+    uint32_t height = BMP_565_GetHeight(pbmp);
+    BMP_565_Rect r = { 0, 0, width - 1, height - 1 };
+
+    if (rect != NULL)
+        r = *rect;
+    if (r.x0 > r.x1 || r.y0 > r.y1 || r.x1 >= width || r.y1 >= height)
+        return;
+
+    uint32_t stride = BMP_565_GetBytesPerRow(pbmp);
+    uint8_t* prow   = BMP_565_GetRowAddr(pbmp, r.y0) + (r.x0 << 1);
+    for (uint32_t y = r.y0; y <= r.y1; y++, prow -= stride)
+        BMP_565_LutApplyRow(lut, (uint16_t*)prow, (const uint16_t*)prow, r.x1 - r.x0 + 1);
+
+    BMP_565_HashInvalidate(pbmp, r.x0, r.y0, r.x1, r.y1);
+}
+
+
+/*********************************** Private methods **********************************/
+
+static float Eval_curve(const BMP_565_LutCurve* c, float v)
+{
+    if (c == NULL)
+        return v;
+
+    if (c->gamma > 0.0f && c->gamma != 1.0f)
+        v = powf(v, 1.0f / c->gamma);
+    v = (v - 0.5f) * c->contrast + 0.5f + c->brightness;
+
+    if (v < 0.0f) v = 0.0f;
+    if (v > 1.0f) v = 1.0f;
+    return v;
+}
+
+static inline int32_t Clamp_255(int32_t v)
+{
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
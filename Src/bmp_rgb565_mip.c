@@ -0,0 +1,198 @@
+#include "bmp_rgb565_mip.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Private function prototypes */
+static inline uint32_t Align4(uint32_t size);
+static inline uint16_t Average4_565(uint16_t c0, uint16_t c1, uint16_t c2, uint16_t c3);
+static void Downsample(uint8_t* pbmp_Dst, uint8_t* pbmp_Src);
+
+
+// Build up to "max_levels" levels (0 = as many as fit) below "pbmp_Src" with a
+// 2x2 box filter. All downsampled levels share a single allocation.
+// Returns the number of levels including level 0, or -1 on error.
+int32_t BMP_565_MipBuild(BMP_565_Mip* mip, uint8_t* pbmp_Src, uint32_t max_levels)
+{
+    if (mip == NULL || pbmp_Src == NULL)
+        return -1;
+    if (max_levels == 0 || max_levels > BMP_565_MIP_MAX_LEVELS)
+        max_levels = BMP_565_MIP_MAX_LEVELS;
+
+    memset(mip, 0, sizeof(BMP_565_Mip));
+    mip->level[0] = pbmp_Src;
+    mip->levels   = 1;
+
+    // First pass: level sizes. Each level is padded to 4 bytes so that every
+    // level keeps the same pixel alignment as a BMP_565_Create() image.
+    uint32_t w = BMP_565_GetWidth (pbmp_Src);
+    uint32_t h = BMP_565_GetHeight(pbmp_Src);
+    uint32_t total = 0;
+    uint32_t levels = 1;
+    while (levels < max_levels && (w > 1 || h > 1))
+    {
+        w = w > 1 ? w >> 1 : 1;
+        h = h > 1 ? h >> 1 : 1;
+        total += Align4(BMP_565_CalcFileSize(w, h));
+        levels++;
+    }
+    if (levels == 1)
+        return 1;
+
+    mip->block = malloc(total);
+    if (mip->block == NULL)
+        return -1;
+
+    // Second pass: headers
+    uint8_t* p = mip->block;
+    w = BMP_565_GetWidth (pbmp_Src);
+    h = BMP_565_GetHeight(pbmp_Src);
+    for (uint32_t i = 1; i < levels; i++)
+    {
+        w = w > 1 ? w >> 1 : 1;
+        h = h > 1 ? h >> 1 : 1;
+        BMP_565_InitHeader(p, w, h);
+        mip->level[i] = p;
+        p += Align4(BMP_565_CalcFileSize(w, h));
+    }
+    mip->levels = levels;
+
+    BMP_565_MipUpdate(mip);
+    return (int32_t)levels;
+}
+
+
+// Regenerate every level from level 0, e.g. after the source image changed
+void BMP_565_MipUpdate(BMP_565_Mip* mip)
+{
+    if (mip == NULL)
+        return;
+
+    for (uint32_t i = 1; i < mip->levels; i++)
+        Downsample(mip->level[i], mip->level[i - 1]);
+}
+
+
+// Frees the downsampled levels. Level 0 still belongs to the caller.
+void BMP_565_MipFree(BMP_565_Mip* mip)
+{
+    if (mip == NULL)
+        return;
+
+    for (uint32_t i = 1; i < mip->levels; i++)
+        BMP_565_HashDetach(mip->level[i]);
+    free(mip->block);
+    memset(mip, 0, sizeof(BMP_565_Mip));
+}
+
+
+// Pick the level closest to "width" x "height". A level is skipped in favour of
+// the next smaller one while the target is nearer to the smaller one in log2
+// scale on both axes (i.e. below the geometric mean of the two level sizes).
+uint32_t BMP_565_MipSelect(BMP_565_Mip* mip, uint32_t width, uint32_t height)
+{
+    uint32_t l = 0;
+
+    while (l + 1 < mip->levels)
+    {
+        uint32_t w0 = BMP_565_GetWidth (mip->level[l]);
+        uint32_t h0 = BMP_565_GetHeight(mip->level[l]);
+        uint32_t w1 = BMP_565_GetWidth (mip->level[l + 1]);
+        uint32_t h1 = BMP_565_GetHeight(mip->level[l + 1]);
+
+        if ((uint64_t)w0 * w1 < (uint64_t)width * width || (uint64_t)h0 * h1 < (uint64_t)height * height)
+            break;
+        l++;
+    }
+    return l;
+}
+
+
+// Draw the whole image scaled to "width" x "height" at (x, y), nearest-neighbour
+// sampled from the closest level. Clipped against the destination.
+void BMP_565_MipBlitScaled(uint8_t* pbmp_Dst, BMP_565_Mip* mip, int32_t x, int32_t y, uint32_t width, uint32_t height)
+{
+    if (pbmp_Dst == NULL || mip == NULL || mip->levels == 0 || width == 0 || height == 0)
+        return;
+
+    uint8_t* pbmp_Src = mip->level[BMP_565_MipSelect(mip, width, height)];
+    uint32_t src_w = BMP_565_GetWidth (pbmp_Src);
+    uint32_t src_h = BMP_565_GetHeight(pbmp_Src);
+    int32_t  dst_w = (int32_t)BMP_565_GetWidth (pbmp_Dst);
+    int32_t  dst_h = (int32_t)BMP_565_GetHeight(pbmp_Dst);
+
+    int32_t col0 = x < 0 ? -x : 0;
+    int32_t row0 = y < 0 ? -y : 0;
+    int32_t col1 = x + (int32_t)width  > dst_w ? dst_w - x : (int32_t)width;
+    int32_t row1 = y + (int32_t)height > dst_h ? dst_h - y : (int32_t)height;
+    if (col0 >= col1 || row0 >= row1)
+        return;
+
+    // 16.16 steps, sampling at pixel centres
+    uint32_t step_x = (uint32_t)(((uint64_t)src_w << 16) / width);
+    uint32_t step_y = (uint32_t)(((uint64_t)src_h << 16) / height);
+    uint32_t u0 = (step_x >> 1) + step_x * col0;
+    uint32_t v  = (step_y >> 1) + step_y * row0;
+
+    uint32_t dst_stride = BMP_565_GetBytesPerRow(pbmp_Dst);
+    uint8_t* pdst_row   = BMP_565_GetRowAddr(pbmp_Dst, y + row0) + ((x + col0) << 1);
+
+    for (int32_t row = row0; row < row1; row++, v += step_y, pdst_row -= dst_stride)
+    {
+        const uint16_t* psrc = (const uint16_t*)BMP_565_GetRowAddr(pbmp_Src, v >> 16);
+        uint16_t* pd = (uint16_t*)pdst_row;
+        uint32_t  u  = u0;
+
+        for (int32_t col = col0; col < col1; col++, u += step_x)
+            *pd++ = psrc[u >> 16];
+    }
+
+    BMP_565_HashInvalidate(pbmp_Dst, x + col0, y + row0, x + col1 - 1, y + row1 - 1);
+}
+
+
+/*********************************** Private methods **********************************/
+
+static inline uint32_t Align4(uint32_t size)
+{
+    return (size + 3) & ~3UL;
+}
+
+// Rounded mean of four RGB565 pixels. With the channels spread over 32 bits
+// (0x07E0F81F) the sum of four cannot carry from one channel into the next.
+static inline uint16_t Average4_565(uint16_t c0, uint16_t c1, uint16_t c2, uint16_t c3)
+{
+    uint32_t sum = ((c0 | ((uint32_t)c0 << 16)) & 0x07E0F81FUL)
+                 + ((c1 | ((uint32_t)c1 << 16)) & 0x07E0F81FUL)
+                 + ((c2 | ((uint32_t)c2 << 16)) & 0x07E0F81FUL)
+                 + ((c3 | ((uint32_t)c3 << 16)) & 0x07E0F81FUL)
+                 + 0x00401002UL;                    // +2 in every channel
+    sum = (sum >> 2) & 0x07E0F81FUL;
+    return (uint16_t)(sum | (sum >> 16));
+}
+
+// 2x2 box filter. An odd last row/column of the source is dropped, and an axis
+// that is already 1 pixel long is averaged with itself.
+static void Downsample(uint8_t* pbmp_Dst, uint8_t* pbmp_Src)
+{
+    uint32_t dst_w = BMP_565_GetWidth (pbmp_Dst);
+    uint32_t dst_h = BMP_565_GetHeight(pbmp_Dst);
+    uint32_t dx = BMP_565_GetWidth (pbmp_Src) > 1 ? 1 : 0;
+    uint32_t dy = BMP_565_GetHeight(pbmp_Src) > 1 ? 1 : 0;
+
+    for (uint32_t y = 0; y < dst_h; y++)
+    {
+        const uint16_t* ps0 = (const uint16_t*)BMP_565_GetRowAddr(pbmp_Src, (y << dy));
+        const uint16_t* ps1 = (const uint16_t*)BMP_565_GetRowAddr(pbmp_Src, (y << dy) + dy);
+        uint16_t* pd = (uint16_t*)BMP_565_GetRowAddr(pbmp_Dst, y);
+
+        for (uint32_t x = 0; x < dst_w; x++)
+        {
+            uint32_t sx = x << dx;
+            pd[x] = Average4_565(ps0[sx], ps0[sx + dx], ps1[sx], ps1[sx + dx]);
+        }
+    }
+
+    BMP_565_HashInvalidate(pbmp_Dst, 0, 0, dst_w - 1, dst_h - 1);
+}
@@ -0,0 +1,627 @@
+#include "bmp_rgb565_path.h"
+#include "bmp_rgb565_hash.h"
+#include "bmp_pixfmt.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+#define FD_ONE          0x10000UL                       // t = 1.0 for the forward differencing
+#define FD_MIN_STEP     (FD_ONE >> 10)                  // At most 1024 segments per curve
+#define AA_SUB          (1 << BMP_565_PATH_AA_SHIFT)
+#define AA_FULL         (256 >> BMP_565_PATH_AA_SHIFT)  // Coverage of a full pixel on one sub-scanline
+#define PI_F            3.14159265f
+
+typedef struct
+{
+    float   x;
+    int32_t dir;
+} Crossing;
+
+/* Rasterizer scratch. Shared, so paths must not be drawn from two tasks at once. */
+static int16_t  Cover[BMP_565_PATH_MAX_WIDTH + 2];      // Coverage deltas of one pixel row
+static uint16_t Active[BMP_565_PATH_MAX_ACTIVE];
+static Crossing Cross[BMP_565_PATH_MAX_ACTIVE];
+
+/* Private function prototypes */
+static int32_t  Append(BMP_565_Path* path, float x, float y);
+static int32_t  Begin_segment(BMP_565_Path* path);
+static void     Add_edge(BMP_565_Path* path, float x0, float y0, float x1, float y1, int32_t dir);
+static void     Add_poly(BMP_565_Path* path, const BMP_565_Point* p, uint32_t n);
+static void     Add_circle(BMP_565_Path* path, float cx, float cy, float r);
+static void     Add_join(BMP_565_Path* path, BMP_565_Point p, BMP_565_Point d0, BMP_565_Point d1, float hw, const BMP_565_Stroke* stroke);
+static void     Stroke_contour(BMP_565_Path* path, uint32_t start, uint32_t end, uint32_t closed, const BMP_565_Stroke* stroke);
+static int32_t  Rasterize(uint8_t* pbmp, BMP_565_Path* path, BMP_565_FillRule rule, uint8_t aa, uint16_t col);
+static int      Cmp_edge(const void* a, const void* b);
+static inline uint32_t Contour_start(const BMP_565_Path* path, uint32_t i);
+
+
+void BMP_565_PathInit(BMP_565_Path* path, BMP_565_Point* pts, uint32_t max_pts, BMP_565_Edge* edges, uint32_t max_edges)
+{
+    memset(path, 0, sizeof(BMP_565_Path));
+    path->pts       = pts;
+    path->max       = max_pts;
+    path->edges     = edges;
+    path->max_edges = max_edges;
+}
+
+
+void BMP_565_PathClear(BMP_565_Path* path)
+{
+    path->count      = 0;
+    path->contours   = 0;
+    path->closed     = 0;
+    path->edge_count = 0;
+}
+
+
+/* Building: each function returns 0, or -1 when the point or contour storage is full */
+int32_t BMP_565_PathMoveTo(BMP_565_Path* path, float x, float y)
+{
+    // A move directly after a move replaces it
+    if (path->contours > 0 && path->contour_end[path->contours - 1] - Contour_start(path, path->contours - 1) == 1)
+    {
+        path->count--;
+        path->closed &= ~(1UL << (path->contours - 1));
+        path->contour_end[path->contours - 1] = path->count;
+    }
+    else
+    {
+        // Check both stores first so a failed move leaves no empty contour behind
+        if (path->contours == BMP_565_PATH_MAX_CONTOURS || path->count == path->max)
+            return -1;
+        path->contour_end[path->contours++] = path->count;
+    }
+
+    return Append(path, x, y);
+}
+
+
+int32_t BMP_565_PathLineTo(BMP_565_Path* path, float x, float y)
+{
+    if (path->contours == 0)
+        return BMP_565_PathMoveTo(path, x, y);
+    if (Begin_segment(path) != 0)
+        return -1;
+
+    return Append(path, x, y);
+}
+
+
+int32_t BMP_565_PathQuadTo(BMP_565_Path* path, float cx, float cy, float x, float y)
+{
+    if (path->contours == 0)
+        return BMP_565_PathMoveTo(path, x, y);
+    if (Begin_segment(path) != 0)
+        return -1;
+
+    // Degree elevation: the same curve as a cubic
+    BMP_565_Point p0 = path->pts[path->count - 1];
+    return BMP_565_PathCubicTo(path, p0.x + (cx - p0.x) * (2.0f / 3.0f), p0.y + (cy - p0.y) * (2.0f / 3.0f),
+                                     x    + (cx - x   ) * (2.0f / 3.0f), y    + (cy - y   ) * (2.0f / 3.0f), x, y);
+}
+
+
+// Flatten with adaptive forward differencing: the curve is walked with plain
+// additions, and the step is halved or doubled (exactly, by rescaling the
+// differences) so that each chord stays within BMP_565_PATH_TOLERANCE.
+int32_t BMP_565_PathCubicTo(BMP_565_Path* path, float c1x, float c1y, float c2x, float c2y, float x, float y)
+{
+    if (path->contours == 0)
+        return BMP_565_PathMoveTo(path, x, y);
+    if (Begin_segment(path) != 0)
+        return -1;
+
+    BMP_565_Point p0 = path->pts[path->count - 1];
+
+    // p(t) = a*t^3 + b*t^2 + c*t + p0, differences for a step of 1
+    float ax = -p0.x + 3.0f * (c1x - c2x) + x;
+    float ay = -p0.y + 3.0f * (c1y - c2y) + y;
+    float bx = 3.0f * (p0.x - 2.0f * c1x + c2x);
+    float by = 3.0f * (p0.y - 2.0f * c1y + c2y);
+    float d1x = ax + bx + 3.0f * (c1x - p0.x);
+    float d1y = ay + by + 3.0f * (c1y - p0.y);
+    float d2x = 6.0f * ax + 2.0f * bx;
+    float d2y = 6.0f * ay + 2.0f * by;
+    float d3x = 6.0f * ax;
+    float d3y = 6.0f * ay;
+
+    // A chord deviates from the curve by about |d2| / 8
+    const float tol = BMP_565_PATH_TOLERANCE;
+    float px = p0.x, py = p0.y;
+    uint32_t t = 0, step = FD_ONE;
+
+    while (t < FD_ONE)
+    {
+        while (step > FD_MIN_STEP && fabsf(d2x) + fabsf(d2y) > 8.0f * tol)
+        {
+            d3x *= 0.125f;              d3y *= 0.125f;
+            d2x  = d2x * 0.25f - d3x;   d2y  = d2y * 0.25f - d3y;
+            d1x  = (d1x - d2x) * 0.5f;  d1y  = (d1y - d2y) * 0.5f;
+            step >>= 1;
+        }
+        while (step < FD_ONE && (t & ((step << 1) - 1)) == 0 && fabsf(d2x + d3x) + fabsf(d2y + d3y) <= tol)
+        {
+            d1x  = 2.0f * d1x + d2x;    d1y  = 2.0f * d1y + d2y;
+            d2x  = 4.0f * (d2x + d3x);  d2y  = 4.0f * (d2y + d3y);
+            d3x *= 8.0f;                d3y *= 8.0f;
+            step <<= 1;
+        }
+
+        px  += d1x;     py  += d1y;
+        d1x += d2x;     d1y += d2y;
+        d2x += d3x;     d2y += d3y;
+        t   += step;
+
+        if (Append(path, t < FD_ONE ? px : x, t < FD_ONE ? py : y) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+
+void BMP_565_PathClose(BMP_565_Path* path)
+{
+    if (path->contours > 0)
+        path->closed |= 1UL << (path->contours - 1);
+}
+
+
+// Fill all contours (each one implicitly closed).
+// Returns -1 if the edge storage or BMP_565_PATH_MAX_ACTIVE ran out; the result is then incomplete.
+int32_t BMP_565_PathFill(uint8_t* pbmp, BMP_565_Path* path, BMP_565_FillRule rule, uint8_t aa, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (pbmp == NULL || path == NULL)
+        return -1;
+
+    path->edge_count = 0;
+    for (uint32_t c = 0; c < path->contours; c++)
+    {
+        uint32_t start = Contour_start(path, c);
+        uint32_t end   = path->contour_end[c];
+
+        for (uint32_t i = start; i < end; i++)
+        {
+            const BMP_565_Point* p0 = &path->pts[i];
+            const BMP_565_Point* p1 = &path->pts[i + 1 < end ? i + 1 : start];
+            Add_edge(path, p0->x, p0->y, p1->x, p1->y, 1);
+        }
+    }
+
+    return Rasterize(pbmp, path, rule, aa, COL_RGB565(r, g, b));
+}
+
+
+// Stroke all contours. The outline is built from one quad per segment plus
+// join and cap polygons, all with the same orientation, and filled in one pass
+// with the non-zero rule, so overlaps are not blended twice in AA mode.
+// Returns -1 if the edge storage or BMP_565_PATH_MAX_ACTIVE ran out; the result is then incomplete.
+int32_t BMP_565_PathStroke(uint8_t* pbmp, BMP_565_Path* path, const BMP_565_Stroke* stroke, uint8_t aa, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (pbmp == NULL || path == NULL || stroke == NULL)
+        return -1;
+    if (stroke->width <= 0.0f)
+        return 0;
+
+    path->edge_count = 0;
+    for (uint32_t c = 0; c < path->contours; c++)
+        Stroke_contour(path, Contour_start(path, c), path->contour_end[c], (path->closed >> c) & 0x01, stroke);
+
+    return Rasterize(pbmp, path, BMP_565_FILL_NONZERO, aa, COL_RGB565(r, g, b));
+}
+
+
+/*********************************** Private methods **********************************/
+
+static inline uint32_t Contour_start(const BMP_565_Path* path, uint32_t i)
+{
+    return i > 0 ? path->contour_end[i - 1] : 0;
+}
+
+static int32_t Append(BMP_565_Path* path, float x, float y)
+{
+    if (path->count == path->max)
+        return -1;
+
+    path->pts[path->count].x = x;
+    path->pts[path->count].y = y;
+    path->count++;
+    path->contour_end[path->contours - 1] = path->count;
+    return 0;
+}
+
+// Drawing on from a closed contour starts a new one at its first point
+static int32_t Begin_segment(BMP_565_Path* path)
+{
+    uint32_t last = path->contours - 1;
+    if (((path->closed >> last) & 0x01) == 0)
+        return 0;
+
+    BMP_565_Point p = path->pts[Contour_start(path, last)];
+    if (path->contours == BMP_565_PATH_MAX_CONTOURS || path->count == path->max)
+        return -1;
+    path->contour_end[path->contours++] = path->count;
+    return Append(path, p.x, p.y);
+}
+
+// Horizontal edges never cross a scanline and are dropped. Once the storage is
+// full edges are only counted, so that edge_count > max_edges flags the overflow.
+static void Add_edge(BMP_565_Path* path, float x0, float y0, float x1, float y1, int32_t dir)
+{
+    if (y0 == y1)
+        return;
+    if (path->edge_count++ >= path->max_edges)
+        return;
+
+    BMP_565_Edge* e = &path->edges[path->edge_count - 1];
+    if (y0 > y1)
+    {
+        float swap;
+        swap = x0; x0 = x1; x1 = swap;
+        swap = y0; y0 = y1; y1 = swap;
+        dir = -dir;
+    }
+    e->x0   = x0;
+    e->y0   = y0;
+    e->x1   = x1;
+    e->y1   = y1;
+    e->dxdy = (x1 - x0) / (y1 - y0);
+    e->dir  = dir;
+}
+
+// Closed convex polygon, emitted with positive orientation whatever its vertex order
+static void Add_poly(BMP_565_Path* path, const BMP_565_Point* p, uint32_t n)
+{
+    float area = 0.0f;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const BMP_565_Point* q = &p[i + 1 < n ? i + 1 : 0];
+        area += p[i].x * q->y - q->x * p[i].y;
+    }
+    if (area == 0.0f)
+        return;
+
+    int32_t dir = area > 0.0f ? 1 : -1;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const BMP_565_Point* q = &p[i + 1 < n ? i + 1 : 0];
+        Add_edge(path, p[i].x, p[i].y, q->x, q->y, dir);
+    }
+}
+
+// Regular polygon whose chords stay within the flattening tolerance
+static void Add_circle(BMP_565_Path* path, float cx, float cy, float r)
+{
+    uint32_t n = 8;
+    if (r > BMP_565_PATH_TOLERANCE)
+        n = (uint32_t)ceilf(PI_F / acosf(1.0f - BMP_565_PATH_TOLERANCE / r));
+    if (n < 8)  n = 8;
+    if (n > 64) n = 64;
+
+    float cs = cosf(2.0f * PI_F / n);
+    float sn = sinf(2.0f * PI_F / n);
+    float vx = r, vy = 0.0f;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float nx = vx * cs - vy * sn;
+        float ny = vx * sn + vy * cs;
+        if (i == n - 1)
+        {
+            nx = r;
+            ny = 0.0f;
+        }
+        Add_edge(path, cx + vx, cy + vy, cx + nx, cy + ny, 1);
+        vx = nx;
+        vy = ny;
+    }
+}
+
+// Join at "p" between unit directions "d0" (incoming) and "d1" (outgoing).
+// Only the outer side needs filling; the inner side is covered by the segment quads.
+static void Add_join(BMP_565_Path* path, BMP_565_Point p, BMP_565_Point d0, BMP_565_Point d1, float hw, const BMP_565_Stroke* stroke)
+{
+    float cross = d0.x * d1.y - d0.y * d1.x;
+    float dot   = d0.x * d1.x + d0.y * d1.y;
+    if (fabsf(cross) < 1e-6f && dot > 0.0f)
+        return;
+
+    if (stroke->join == BMP_565_JOIN_ROUND)
+    {
+        Add_circle(path, p.x, p.y, hw);
+        return;
+    }
+
+    float s = cross > 0.0f ? -hw : hw;
+    BMP_565_Point n0 = { -d0.y * s, d0.x * s };
+    BMP_565_Point n1 = { -d1.y * s, d1.x * s };
+    BMP_565_Point poly[4];
+
+    poly[0] = p;
+    poly[1].x = p.x + n0.x;
+    poly[1].y = p.y + n0.y;
+
+    if (stroke->join == BMP_565_JOIN_MITER)
+    {
+        // Miter tip on the bisector at hw / cos(angle / 2)
+        float mx = n0.x + n1.x;
+        float my = n0.y + n1.y;
+        float mdot = mx * n0.x + my * n0.y;
+        if (mdot > 1e-6f)
+        {
+            float k = hw * hw / mdot;
+            if (k * k * (mx * mx + my * my) <= stroke->miter_limit * stroke->miter_limit * hw * hw)
+            {
+                poly[2].x = p.x + mx * k;
+                poly[2].y = p.y + my * k;
+                poly[3].x = p.x + n1.x;
+                poly[3].y = p.y + n1.y;
+                Add_poly(path, poly, 4);
+                return;
+            }
+        }
+    }
+
+    // Bevel, also the fallback past the miter limit
+    poly[2].x = p.x + n1.x;
+    poly[2].y = p.y + n1.y;
+    Add_poly(path, poly, 3);
+}
+
+static void Stroke_contour(BMP_565_Path* path, uint32_t start, uint32_t end, uint32_t closed, const BMP_565_Stroke* stroke)
+{
+    const BMP_565_Point* pts = path->pts;
+    uint32_t n  = end - start;
+    float    hw = stroke->width * 0.5f;
+
+    // A bare move has no segment and draws nothing, as in BMP_565_PathFill
+    if (n < 2)
+        return;
+
+    // First and last segment of non-zero length
+    uint32_t nseg = closed ? n : n - 1;
+    int32_t  first = -1, last = -1;
+    for (uint32_t k = 0; k < nseg; k++)
+    {
+        const BMP_565_Point* a = &pts[start + k];
+        const BMP_565_Point* b = &pts[start + (k + 1) % n];
+        if (a->x != b->x || a->y != b->y)
+        {
+            if (first < 0)
+                first = k;
+            last = k;
+        }
+    }
+
+    // A lone point only shows up with round or square caps
+    if (first < 0)
+    {
+        BMP_565_Point p = pts[start];
+        if (stroke->cap == BMP_565_CAP_ROUND)
+            Add_circle(path, p.x, p.y, hw);
+        else if (stroke->cap == BMP_565_CAP_SQUARE)
+        {
+            BMP_565_Point sq[4] = { { p.x - hw, p.y - hw }, { p.x + hw, p.y - hw }, { p.x + hw, p.y + hw }, { p.x - hw, p.y + hw } };
+            Add_poly(path, sq, 4);
+        }
+        return;
+    }
+
+    BMP_565_Point d_first = { 0.0f, 0.0f }, d_prev = { 0.0f, 0.0f };
+    for (uint32_t k = first; k <= (uint32_t)last; k++)
+    {
+        BMP_565_Point a = pts[start + k];
+        BMP_565_Point b = pts[start + (k + 1) % n];
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        float len = sqrtf(dx * dx + dy * dy);
+        if (len == 0.0f)
+            continue;
+
+        BMP_565_Point d = { dx / len, dy / len };
+        if (k == (uint32_t)first)
+            d_first = d;
+        else
+            Add_join(path, a, d_prev, d, hw, stroke);
+        d_prev = d;
+
+        if (!closed && stroke->cap == BMP_565_CAP_SQUARE)
+        {
+            if (k == (uint32_t)first) { a.x -= d.x * hw; a.y -= d.y * hw; }
+            if (k == (uint32_t)last)  { b.x += d.x * hw; b.y += d.y * hw; }
+        }
+
+        BMP_565_Point quad[4] =
+        {
+            { a.x - d.y * hw, a.y + d.x * hw },
+            { b.x - d.y * hw, b.y + d.x * hw },
+            { b.x + d.y * hw, b.y - d.x * hw },
+            { a.x + d.y * hw, a.y - d.x * hw }
+        };
+        Add_poly(path, quad, 4);
+    }
+
+    if (closed)
+        Add_join(path, pts[start + first], d_prev, d_first, hw, stroke);
+    else if (stroke->cap == BMP_565_CAP_ROUND)
+    {
+        Add_circle(path, pts[start + first].x, pts[start + first].y, hw);
+        Add_circle(path, pts[start + (last + 1) % n].x, pts[start + (last + 1) % n].y, hw);
+    }
+}
+
+// Scanline fill of the edge list. Without AA a pixel is set when its centre is
+// inside. With AA every row is sampled on AA_SUB sub-scanlines; each span adds
+// its exact horizontal coverage to a delta buffer, which is summed up once per row.
+static int32_t Rasterize(uint8_t* pbmp, BMP_565_Path* path, BMP_565_FillRule rule, uint8_t aa, uint16_t col)
+{
+    int32_t  width  = (int32_t)BMP_565_GetWidth (pbmp);
+    int32_t  height = (int32_t)BMP_565_GetHeight(pbmp);
+    uint32_t n      = path->edge_count;
+    int32_t  overflow = 0;
+
+    if (n > path->max_edges)
+    {
+        n = path->max_edges;
+        overflow = 1;
+    }
+    if (n == 0)
+        return overflow ? -1 : 0;
+    if (width > BMP_565_PATH_MAX_WIDTH)
+        aa = 0;
+
+    BMP_565_Edge* edges = path->edges;
+    qsort(edges, n, sizeof(BMP_565_Edge), Cmp_edge);
+
+    float y_max = edges[0].y1;
+    for (uint32_t i = 1; i < n; i++)
+    {
+        if (edges[i].y1 > y_max)
+            y_max = edges[i].y1;
+    }
+    int32_t row0 = (int32_t)floorf(edges[0].y0);
+    int32_t row1 = (int32_t)ceilf(y_max);
+    if (row0 < 0)       row0 = 0;
+    if (row1 > height)  row1 = height;
+
+    uint32_t stride = BMP_565_GetBytesPerRow(pbmp);
+    uint8_t* pdata  = BMP_565_GetRowAddr(pbmp, height - 1);
+    int32_t  sub    = aa ? AA_SUB : 1;
+    uint32_t next = 0, nact = 0;
+    int32_t  dirty_x0 = width, dirty_y0 = height, dirty_x1 = -1, dirty_y1 = -1;
+
+    for (int32_t py = row0; py < row1; py++)
+    {
+        uint16_t* prow = (uint16_t*)(pdata + stride * (height - 1 - py));
+        int32_t   cov_min = width + 1, cov_max = -1;
+
+        for (int32_t s = 0; s < sub; s++)
+        {
+            float ys = py + (s + 0.5f) / sub;
+
+            // Retire finished edges, pick up new ones
+            for (uint32_t i = 0; i < nact; )
+            {
+                if (edges[Active[i]].y1 <= ys)
+                    Active[i] = Active[--nact];
+                else
+                    i++;
+            }
+            for (; next < n && edges[next].y0 <= ys; next++)
+            {
+                if (edges[next].y1 <= ys)
+                    continue;
+                if (nact == BMP_565_PATH_MAX_ACTIVE)
+                {
+                    overflow = 1;
+                    continue;
+                }
+                Active[nact++] = next;
+            }
+
+            // Crossings, sorted by x
+            for (uint32_t i = 0; i < nact; i++)
+            {
+                const BMP_565_Edge* e = &edges[Active[i]];
+                Crossing c = { e->x0 + (ys - e->y0) * e->dxdy, e->dir };
+                int32_t j = i;
+                for (; j > 0 && Cross[j - 1].x > c.x; j--)
+                    Cross[j] = Cross[j - 1];
+                Cross[j] = c;
+            }
+
+            int32_t wind = 0;
+            float   xa = 0.0f;
+            for (uint32_t i = 0; i < nact; i++)
+            {
+                int32_t was_in = rule == BMP_565_FILL_EVENODD ? (wind & 1) : (wind != 0);
+                wind += Cross[i].dir;
+                int32_t is_in  = rule == BMP_565_FILL_EVENODD ? (wind & 1) : (wind != 0);
+
+                if (!was_in && is_in)
+                {
+                    xa = Cross[i].x;
+                    continue;
+                }
+                if (!was_in || is_in)
+                    continue;
+
+                float xb = Cross[i].x;
+                if (aa)
+                {
+                    if (xa < 0.0f)          xa = 0.0f;
+                    if (xb > (float)width)  xb = (float)width;
+                    if (xa >= xb)
+                        continue;
+
+                    int32_t a24 = (int32_t)(xa * 256.0f);
+                    int32_t b24 = (int32_t)(xb * 256.0f);
+                    int32_t ia = a24 >> 8, fa = (a24 & 0xFF) >> BMP_565_PATH_AA_SHIFT;
+                    int32_t ib = b24 >> 8, fb = (b24 & 0xFF) >> BMP_565_PATH_AA_SHIFT;
+
+                    Cover[ia]     += AA_FULL - fa;
+                    Cover[ia + 1] += fa;
+                    Cover[ib]     -= AA_FULL - fb;
+                    Cover[ib + 1] -= fb;
+                    if (ia < cov_min) cov_min = ia;
+                    if (ib > cov_max) cov_max = ib;
+                }
+                else
+                {
+                    int32_t x0 = (int32_t)ceilf(xa - 0.5f);
+                    int32_t x1 = (int32_t)ceilf(xb - 0.5f) - 1;
+                    if (x0 < 0)         x0 = 0;
+                    if (x1 > width - 1) x1 = width - 1;
+                    if (x0 > x1)
+                        continue;
+
+                    for (int32_t x = x0; x <= x1; x++)
+                        prow[x] = col;
+                    if (x0 < dirty_x0) dirty_x0 = x0;
+                    if (x1 > dirty_x1) dirty_x1 = x1;
+                    if (py < dirty_y0) dirty_y0 = py;
+                    dirty_y1 = py;
+                }
+            }
+        }
+
+        if (cov_max < 0)
+            continue;
+
+        // Resolve the row: running sum of the deltas is the coverage (0..256)
+        int32_t acc = 0;
+        int32_t x_end = cov_max < width - 1 ? cov_max : width - 1;
+        for (int32_t x = cov_min; x <= x_end; x++)
+        {
+            acc += Cover[x];
+            Cover[x] = 0;
+            if (acc <= 0)
+                continue;
+
+            uint32_t w = acc >= 256 ? 32 : (uint32_t)(acc + 4) >> 3;
+            if (w == 32)
+                prow[x] = col;
+            else if (w > 0)
+                prow[x] = BMP_PF_Lerp565(prow[x], col, w);
+        }
+        for (int32_t x = x_end + 1; x <= cov_max + 1; x++)
+            Cover[x] = 0;
+
+        if (cov_min < dirty_x0) dirty_x0 = cov_min;
+        if (x_end   > dirty_x1) dirty_x1 = x_end;
+        if (py < dirty_y0) dirty_y0 = py;
+        dirty_y1 = py;
+    }
+
+    if (dirty_x1 >= 0)
+        BMP_565_HashInvalidate(pbmp, dirty_x0, dirty_y0, dirty_x1, dirty_y1);
+
+    return overflow ? -1 : 0;
+}
+
+static int Cmp_edge(const void* a, const void* b)
+{
+    float ya = ((const BMP_565_Edge*)a)->y0;
+    float yb = ((const BMP_565_Edge*)b)->y0;
+    return ya < yb ? -1 : ya > yb ? 1 : 0;
+}
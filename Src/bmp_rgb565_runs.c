@@ -0,0 +1,161 @@
+#include "bmp_rgb565_runs.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Private function prototypes */
+static BMP_565_RunSprite* Encode(uint8_t* pbmp_Src, const BMP_565_Rect* src_rect, uint16_t key, const uint8_t* mask, uint32_t mask_stride);
+static inline uint32_t Is_opaque(const uint16_t* prow, uint32_t x, uint16_t key, const uint8_t* pmask);
+
+
+// Encode every row of "src_rect" (NULL = whole image) as runs of pixels that differ from the colour key
+BMP_565_RunSprite* BMP_565_RunsFromKey(uint8_t* pbmp_Src, const BMP_565_Rect* src_rect, uint8_t r, uint8_t g, uint8_t b)
+{
+    return Encode(pbmp_Src, src_rect, COL_RGB565(r, g, b), NULL, 0);
+}
+
+
+// Encode every row of "src_rect" (NULL = whole image) as runs of set mask bits.
+// The mask is 1bpp, LSB first, top row first, "mask_stride" bytes per row, and
+// is indexed relative to the top-left corner of "src_rect".
+BMP_565_RunSprite* BMP_565_RunsFromMask(uint8_t* pbmp_Src, const BMP_565_Rect* src_rect, const uint8_t* mask, uint32_t mask_stride)
+{
+    if (mask == NULL)
+        return NULL;
+
+    return Encode(pbmp_Src, src_rect, 0, mask, mask_stride);
+}
+
+
+void BMP_565_RunsFree(BMP_565_RunSprite* rs)
+{
+    free(rs);
+}
+
+
+// Draw the opaque runs of "rs" at (x, y). There is no per-pixel key test:
+// each visible run is one memcpy().
+void BMP_565_BlitRuns(uint8_t* pbmp_Dst, int32_t x, int32_t y, uint8_t* pbmp_Src, const BMP_565_RunSprite* rs)
+{
+    if (pbmp_Dst == NULL || pbmp_Src == NULL || rs == NULL)
+        return;
+
+    int32_t width  = (int32_t)BMP_565_GetWidth (pbmp_Dst);
+    int32_t height = (int32_t)BMP_565_GetHeight(pbmp_Dst);
+
+    // Vertical clip
+    int32_t row0 = y < 0 ? -y : 0;
+    int32_t row1 = y + rs->height > height ? height - y : rs->height;
+    if (row0 >= row1 || x >= width || x + rs->width <= 0)
+        return;
+
+    uint32_t src_stride = BMP_565_GetBytesPerRow(pbmp_Src);
+    uint32_t dst_stride = BMP_565_GetBytesPerRow(pbmp_Dst);
+    uint8_t* psrc = BMP_565_GetRowAddr(pbmp_Src, rs->src_y + row0) + (rs->src_x << 1);
+    uint8_t* pdst = BMP_565_GetRowAddr(pbmp_Dst, y + row0);
+
+    // Horizontal clip, in sprite coordinates
+    int32_t clip_x0 = x < 0 ? -x : 0;
+    int32_t clip_x1 = x + rs->width > width ? width - x : rs->width;
+
+    for (int32_t row = row0; row < row1; row++, psrc -= src_stride, pdst -= dst_stride)
+    {
+        for (uint32_t i = rs->row_start[row]; i < rs->row_start[row + 1]; i++)
+        {
+            int32_t rx0 = rs->runs[i].x;
+            int32_t rx1 = rx0 + rs->runs[i].len;
+
+            if (rx0 < clip_x0) rx0 = clip_x0;
+            if (rx1 > clip_x1) rx1 = clip_x1;
+            if (rx0 >= rx1)
+                continue;
+
+            memcpy(pdst + ((x + rx0) << 1), psrc + (rx0 << 1), (rx1 - rx0) << 1);
+        }
+    }
+
+    BMP_565_HashInvalidate(pbmp_Dst, x + clip_x0, y + row0, x + clip_x1 - 1, y + row1 - 1);
+}
+
+
+/*********************************** Private methods **********************************/
+
+static inline uint32_t Is_opaque(const uint16_t* prow, uint32_t x, uint16_t key, const uint8_t* pmask)
+{
+    if (pmask != NULL)
+        return (pmask[x >> 3] >> (x & 7)) & 0x01;
+
+    return prow[x] != key;
+}
+
+// Two passes: count the runs, then allocate header, row table and runs in one block and fill them
+static BMP_565_RunSprite* Encode(uint8_t* pbmp_Src, const BMP_565_Rect* src_rect, uint16_t key, const uint8_t* mask, uint32_t mask_stride)
+{
+    if (pbmp_Src == NULL)
+        return NULL;
+
+    uint32_t src_w = BMP_565_GetWidth (pbmp_Src);
+    uint32_t src_h = BMP_565_GetHeight(pbmp_Src);
+    BMP_565_Rect r = { 0, 0, src_w - 1, src_h - 1 };
+
+    if (src_rect != NULL)
+        r = *src_rect;
+    if (r.x0 > r.x1 || r.y0 > r.y1 || r.x1 >= src_w || r.y1 >= src_h)
+        return NULL;
+
+    uint32_t w = r.x1 - r.x0 + 1;
+    uint32_t h = r.y1 - r.y0 + 1;
+
+    uint32_t run_count = 0;
+    for (uint32_t y = 0; y < h; y++)
+    {
+        const uint16_t* prow  = (const uint16_t*)(BMP_565_GetRowAddr(pbmp_Src, r.y0 + y) + (r.x0 << 1));
+        const uint8_t*  pmask = mask != NULL ? mask + y * mask_stride : NULL;
+        uint32_t prev = 0;
+
+        for (uint32_t x = 0; x < w; x++)
+        {
+            uint32_t cur = Is_opaque(prow, x, key, pmask);
+            if (cur && !prev)
+                run_count++;
+            prev = cur;
+        }
+    }
+
+    BMP_565_RunSprite* rs = malloc(sizeof(BMP_565_RunSprite) + (h + 1) * sizeof(uint32_t) + run_count * sizeof(BMP_565_Run));
+    if (rs == NULL)
+        return NULL;
+
+    rs->src_x     = r.x0;
+    rs->src_y     = r.y0;
+    rs->width     = w;
+    rs->height    = h;
+    rs->row_start = (uint32_t*)(rs + 1);
+    rs->runs      = (BMP_565_Run*)(rs->row_start + h + 1);
+
+    uint32_t n = 0;
+    for (uint32_t y = 0; y < h; y++)
+    {
+        const uint16_t* prow  = (const uint16_t*)(BMP_565_GetRowAddr(pbmp_Src, r.y0 + y) + (r.x0 << 1));
+        const uint8_t*  pmask = mask != NULL ? mask + y * mask_stride : NULL;
+
+        rs->row_start[y] = n;
+        for (uint32_t x = 0; x < w; )
+        {
+            if (!Is_opaque(prow, x, key, pmask))
+            {
+                x++;
+                continue;
+            }
+            rs->runs[n].x = x;
+            while (x < w && Is_opaque(prow, x, key, pmask))
+                x++;
+            rs->runs[n].len = x - rs->runs[n].x;
+            n++;
+        }
+    }
+    rs->row_start[h] = n;
+
+    return rs;
+}
@@ -0,0 +1,129 @@
+#include "bmp_rgb565_stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Private function prototypes */
+static inline void Count_pixel(uint32_t* r, uint32_t* g, uint32_t* b, uint32_t c);
+static void Channel_stats(const uint32_t* bins, uint32_t levels, uint32_t ch, BMP_565_Stats* stats);
+
+
+// Histogram of "rect" (NULL = whole image). Pixels are read two per 32-bit
+// load; even and odd pixels go to separate bin copies, so two increments of
+// the same bin never follow each other, and the copies are summed at the end.
+void BMP_565_Histogram(uint8_t* pbmp, const BMP_565_Rect* rect, BMP_565_Hist* hist)
+{
+    if (hist == NULL)
+        return;
+    memset(hist, 0, sizeof(BMP_565_Hist));
+    if (pbmp == NULL)
+        return;
+
+    uint32_t width  = BMP_565_GetWidth (pbmp);
+    uint32_t height = BMP_565_GetHeight(pbmp);
+    BMP_565_Rect r = { 0, 0, width - 1, height - 1 };
+
+    if (rect != NULL)
+        r = *rect;
+    if (r.x0 > r.x1 || r.y0 > r.y1 || r.x1 >= width || r.y1 >= height)
+        return;
+
+    uint32_t* odd_r = hist->odd;
+    uint32_t* odd_g = hist->odd + 32;
+    uint32_t* odd_b = hist->odd + 32 + 64;
+    uint32_t  stride = BMP_565_GetBytesPerRow(pbmp);
+    uint8_t*  prow   = BMP_565_GetRowAddr(pbmp, r.y0) + (r.x0 << 1);
+
+    for (uint32_t y = r.y0; y <= r.y1; y++, prow -= stride)
+    {
+        const uint16_t* p = (const uint16_t*)prow;
+        uint32_t n = r.x1 - r.x0 + 1;
+
+        // Rows of the 70-byte-header BMP start on a half word: peel one pixel to align
+        if (((uintptr_t)p & 0x02) && n > 0)
+        {
+            Count_pixel(odd_r, odd_g, odd_b, *p++);
+            n--;
+        }
+
+        const uint32_t* pw = (const uint32_t*)p;
+        for (uint32_t i = n >> 1; i > 0; i--)
+        {
+            uint32_t w = *pw++;
+            Count_pixel(hist->r, hist->g, hist->b, w & 0xFFFF);
+            Count_pixel(odd_r,   odd_g,   odd_b,   w >> 16);
+        }
+
+        if (n & 0x01)
+            Count_pixel(hist->r, hist->g, hist->b, *(const uint16_t*)pw);
+    }
+
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        hist->r[i] += odd_r[i];
+        hist->b[i] += odd_b[i];
+    }
+    for (uint32_t i = 0; i < 64; i++)
+        hist->g[i] += odd_g[i];
+}
+
+
+// Min, max, mean and variance are exact functions of the histogram: no second pass over the pixels
+void BMP_565_StatsFromHist(const BMP_565_Hist* hist, BMP_565_Stats* stats)
+{
+    memset(stats, 0, sizeof(BMP_565_Stats));
+    Channel_stats(hist->r, 32, 0, stats);
+    Channel_stats(hist->g, 64, 1, stats);
+    Channel_stats(hist->b, 32, 2, stats);
+}
+
+
+// "hist" receives the histogram and is the working storage (about 1 KB), so
+// it is caller-provided rather than put on a small task stack
+void BMP_565_GetStats(uint8_t* pbmp, const BMP_565_Rect* rect, BMP_565_Stats* stats, BMP_565_Hist* hist)
+{
+    if (stats == NULL || hist == NULL)
+        return;
+
+    BMP_565_Histogram(pbmp, rect, hist);
+    BMP_565_StatsFromHist(hist, stats);
+}
+
+
+/*********************************** Private methods **********************************/
+
+static inline void Count_pixel(uint32_t* r, uint32_t* g, uint32_t* b, uint32_t c)
+{
+    r[c >> 11]++;
+    g[(c >> 5) & 0x3F]++;
+    b[c & 0x1F]++;
+}
+
+static void Channel_stats(const uint32_t* bins, uint32_t levels, uint32_t ch, BMP_565_Stats* stats)
+{
+    uint32_t n = 0;
+    uint64_t sum = 0, sum2 = 0;
+    int32_t  lo = -1, hi = -1;
+
+    for (uint32_t i = 0; i < levels; i++)
+    {
+        if (bins[i] == 0)
+            continue;
+        if (lo < 0)
+            lo = i;
+        hi = i;
+        n    += bins[i];
+        sum  += (uint64_t)bins[i] * i;
+        sum2 += (uint64_t)bins[i] * i * i;
+    }
+
+    stats->count = n;
+    if (n == 0)
+        return;
+
+    float mean = (float)sum / n;
+    stats->min[ch]      = (uint8_t)lo;
+    stats->max[ch]      = (uint8_t)hi;
+    stats->mean[ch]     = mean;
+    stats->variance[ch] = (float)sum2 / n - mean * mean;
+}
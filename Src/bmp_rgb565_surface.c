@@ -0,0 +1,306 @@
+#include "bmp_rgb565_surface.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef BMP_565_SURFACE_PTHREAD
+#include <time.h>
+#include <errno.h>
+#else
+#include "task.h"
+#endif
+
+
+/* Private function prototypes */
+static int32_t Sem_create(BMP_565_Sem* sem, uint32_t max, uint32_t initial);
+static void Sem_delete(BMP_565_Sem* sem);
+static int32_t Sem_take(BMP_565_Sem* sem, uint32_t timeout_ms);
+static void Sem_give(BMP_565_Sem* sem);
+static inline void Lock(BMP_565_Surface* s);
+static inline void Unlock(BMP_565_Surface* s);
+
+
+// "nbuf" is 2 (double) or 3 (triple buffering). Buffer 0 starts as the front
+// buffer; the others are free for drawing.
+int32_t BMP_565_SurfaceCreate(BMP_565_Surface* s, uint32_t width, uint32_t height, uint32_t nbuf)
+{
+    if (s == NULL || nbuf < 2 || nbuf > BMP_565_SURFACE_MAX_BUF)
+        return -1;
+
+    memset(s, 0, sizeof(BMP_565_Surface));
+#ifdef BMP_565_SURFACE_PTHREAD
+    pthread_mutex_init(&s->lock, NULL);
+#endif
+    for (uint32_t i = 0; i < nbuf; i++)
+    {
+        s->buf[i] = BMP_565_Create(width, height);
+        if (s->buf[i] == NULL)
+        {
+            BMP_565_SurfaceFree(s);
+            return -1;
+        }
+        s->count = i + 1;
+    }
+
+    s->free_mask = (uint8_t)(((1U << nbuf) - 1) & ~1U);
+    s->back  = -1;
+    s->ready = -1;
+    s->front = 0;
+
+    if (Sem_create(&s->sem_free,  nbuf - 1, nbuf - 1) != 0 ||
+        Sem_create(&s->sem_ready, 1, 0) != 0 ||
+        Sem_create(&s->sem_fence, 1, 0) != 0)
+    {
+        BMP_565_SurfaceFree(s);
+        return -1;
+    }
+    return 0;
+}
+
+
+void BMP_565_SurfaceFree(BMP_565_Surface* s)
+{
+    if (s == NULL)
+        return;
+
+    for (uint32_t i = 0; i < s->count; i++)
+        BMP_565_Free(s->buf[i]);
+    Sem_delete(&s->sem_free);
+    Sem_delete(&s->sem_ready);
+    Sem_delete(&s->sem_fence);
+#ifdef BMP_565_SURFACE_PTHREAD
+    pthread_mutex_destroy(&s->lock);
+#endif
+    memset(s, 0, sizeof(BMP_565_Surface));
+}
+
+
+// Returns the back buffer to draw into, waiting up to "timeout_ms" for the
+// presenter to give one back, or NULL on timeout.
+// Its content is whatever was drawn into it two (or three) frames ago.
+uint8_t* BMP_565_SurfaceBeginFrame(BMP_565_Surface* s, uint32_t timeout_ms)
+{
+    if (s == NULL || s->count == 0)
+        return NULL;
+    if (s->back >= 0)
+        return s->buf[s->back];
+    if (Sem_take(&s->sem_free, timeout_ms) != 0)
+        return NULL;
+
+    Lock(s);
+    int8_t i = 0;
+    while (!(s->free_mask & (1U << i)))
+        i++;
+    s->free_mask &= ~(1U << i);
+    s->back = i;
+    Unlock(s);
+
+    return s->buf[i];
+}
+
+
+// Publish the back buffer as the newest frame. With triple buffering a
+// finished frame the presenter has not picked up yet is dropped and its buffer
+// reused, so the producer never waits on a slow presenter.
+// Returns the frame number to pass to BMP_565_SurfaceWaitFence, 0 if no frame was begun.
+uint32_t BMP_565_SurfaceEndFrame(BMP_565_Surface* s)
+{
+    if (s == NULL || s->back < 0)
+        return 0;
+
+    Lock(s);
+    int8_t dropped = s->ready;
+    if (dropped >= 0)
+        s->free_mask |= 1U << dropped;
+    s->ready     = s->back;
+    s->ready_seq = ++s->seq;
+    s->back      = -1;
+    uint32_t seq = s->seq;
+    Unlock(s);
+
+    if (dropped >= 0)
+        Sem_give(&s->sem_free);
+    Sem_give(&s->sem_ready);
+    return seq;
+}
+
+
+// Swap the newest finished frame to the front and return it, waiting up to
+// "timeout_ms" for one; NULL if none. The previous front buffer goes back to
+// the producer.
+uint8_t* BMP_565_SurfaceAcquireFront(BMP_565_Surface* s, uint32_t timeout_ms)
+{
+    if (s == NULL || s->count == 0)
+        return NULL;
+    if (Sem_take(&s->sem_ready, timeout_ms) != 0)
+        return NULL;
+
+    Lock(s);
+    if (s->ready < 0)
+    {
+        Unlock(s);
+        return NULL;
+    }
+    int8_t old = s->front;
+    s->front     = s->ready;
+    s->front_seq = s->ready_seq;
+    s->ready     = -1;
+    s->free_mask |= 1U << old;
+    uint8_t* pbmp = s->buf[s->front];
+    Unlock(s);
+
+    Sem_give(&s->sem_free);
+    return pbmp;
+}
+
+
+// Last acquired frame, e.g. to show it again after the window was covered
+uint8_t* BMP_565_SurfaceGetFront(BMP_565_Surface* s)
+{
+    if (s == NULL || s->count == 0)
+        return NULL;
+    return s->buf[s->front];
+}
+
+
+// Called by the presenter once the front buffer is on the panel
+void BMP_565_SurfacePresentDone(BMP_565_Surface* s)
+{
+    if (s == NULL || s->count == 0)
+        return;
+
+    Lock(s);
+    s->presented_seq = s->front_seq;
+    Unlock(s);
+
+    Sem_give(&s->sem_fence);
+}
+
+
+// Wait until frame "seq" (or a later one) has been presented.
+// "timeout_ms" applies to each wakeup of the fence. Returns 0, or -1 on timeout.
+int32_t BMP_565_SurfaceWaitFence(BMP_565_Surface* s, uint32_t seq, uint32_t timeout_ms)
+{
+    if (s == NULL || s->count == 0)
+        return -1;
+
+    // Dropped frames are never presented: a later presented frame also passes the fence
+    while ((int32_t)(s->presented_seq - seq) < 0)
+    {
+        if (Sem_take(&s->sem_fence, timeout_ms) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+
+/*********************************** Private methods **********************************/
+
+#ifdef BMP_565_SURFACE_PTHREAD
+
+static int32_t Sem_create(BMP_565_Sem* sem, uint32_t max, uint32_t initial)
+{
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = initial;
+    sem->max   = max;
+    return 0;
+}
+
+static void Sem_delete(BMP_565_Sem* sem)
+{
+    if (sem->max == 0)
+        return;
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    sem->max = 0;
+}
+
+static int32_t Sem_take(BMP_565_Sem* sem, uint32_t timeout_ms)
+{
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec  += timeout_ms / 1000;
+    until.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (until.tv_nsec >= 1000000000L)
+    {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+
+    int32_t ret = 0;
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && ret == 0)
+    {
+        if (timeout_ms == BMP_565_SURFACE_WAIT_FOREVER)
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        else if (pthread_cond_timedwait(&sem->cond, &sem->lock, &until) == ETIMEDOUT)
+            ret = -1;
+    }
+    if (sem->count > 0)
+    {
+        sem->count--;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+static void Sem_give(BMP_565_Sem* sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max)
+        sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+}
+
+static inline void Lock(BMP_565_Surface* s)
+{
+    pthread_mutex_lock(&s->lock);
+}
+
+static inline void Unlock(BMP_565_Surface* s)
+{
+    pthread_mutex_unlock(&s->lock);
+}
+
+#else
+
+static int32_t Sem_create(BMP_565_Sem* sem, uint32_t max, uint32_t initial)
+{
+    *sem = xSemaphoreCreateCounting(max, initial);
+    return *sem == NULL ? -1 : 0;
+}
+
+static void Sem_delete(BMP_565_Sem* sem)
+{
+    if (*sem == NULL)
+        return;
+    vSemaphoreDelete(*sem);
+    *sem = NULL;
+}
+
+static int32_t Sem_take(BMP_565_Sem* sem, uint32_t timeout_ms)
+{
+    TickType_t ticks = timeout_ms == BMP_565_SURFACE_WAIT_FOREVER ? portMAX_DELAY : (TickType_t)(timeout_ms / portTICK_PERIOD_MS);
+    return xSemaphoreTake(*sem, ticks) == pdTRUE ? 0 : -1;
+}
+
+static void Sem_give(BMP_565_Sem* sem)
+{
+    xSemaphoreGive(*sem);
+}
+
+// The state is a handful of words: a critical section is cheaper than a mutex
+static inline void Lock(BMP_565_Surface* s)
+{
+    (void)s;
+    taskENTER_CRITICAL();
+}
+
+static inline void Unlock(BMP_565_Surface* s)
+{
+    (void)s;
+    taskEXIT_CRITICAL();
+}
+
+#endif
@@ -0,0 +1,275 @@
+#include "bmp_rgb565_tiled.h"
+#include "bmp_rgb565_hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Private function prototypes */
+static inline uint32_t Tile_base(const BMP_565_Tiled* t, uint32_t tx, uint32_t ty);
+static inline uint32_t Spread_bits(uint32_t v);
+
+
+int32_t BMP_565_TiledCreate(BMP_565_Tiled* t, uint32_t width, uint32_t height, BMP_565_TileLayout layout)
+{
+    if (t == NULL || width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF)
+        return -1;
+
+    memset(t, 0, sizeof(BMP_565_Tiled));
+    t->shift  = layout == BMP_565_TILE_8x8 ? 3 : 4;
+    t->layout = layout;
+    t->width  = width;
+    t->height = height;
+
+    uint32_t size = 1UL << t->shift;
+    t->tiles_x = (width  + size - 1) >> t->shift;
+    t->tiles_y = (height + size - 1) >> t->shift;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        if (layout == BMP_565_TILE_MORTON16)
+        {
+            t->lx[i] = (uint8_t) Spread_bits(i);
+            t->ly[i] = (uint8_t)(Spread_bits(i) << 1);
+        }
+        else
+        {
+            t->lx[i] = (uint8_t) i;
+            t->ly[i] = (uint8_t)(i << t->shift);
+        }
+    }
+
+    t->data = calloc((uint32_t)t->tiles_x * t->tiles_y << (t->shift << 1), sizeof(uint16_t));
+    if (t->data == NULL)
+        return -1;
+    return 0;
+}
+
+
+void BMP_565_TiledFree(BMP_565_Tiled* t)
+{
+    if (t == NULL)
+        return;
+
+    free(t->data);
+    t->data = NULL;
+}
+
+
+// Conversions go tile by tile: a tile row is a contiguous run of the linear row
+int32_t BMP_565_TiledFromLinear(BMP_565_Tiled* t, uint8_t* pbmp_Src)
+{
+    if (t == NULL || pbmp_Src == NULL || BMP_565_GetWidth(pbmp_Src) != t->width || BMP_565_GetHeight(pbmp_Src) != t->height)
+        return -1;
+
+    uint32_t size = 1UL << t->shift;
+    for (uint32_t ty = 0; ty < t->tiles_y; ty++)
+    {
+        for (uint32_t tx = 0; tx < t->tiles_x; tx++)
+        {
+            uint16_t* ptile = t->data + Tile_base(t, tx, ty);
+            uint32_t  x0 = tx << t->shift, y0 = ty << t->shift;
+            uint32_t  w  = x0 + size > t->width  ? t->width  - x0 : size;
+            uint32_t  h  = y0 + size > t->height ? t->height - y0 : size;
+
+            for (uint32_t ly = 0; ly < h; ly++)
+            {
+                const uint16_t* psrc = (const uint16_t*)BMP_565_GetRowAddr(pbmp_Src, y0 + ly) + x0;
+                for (uint32_t lx = 0; lx < w; lx++)
+                    ptile[t->lx[lx] + t->ly[ly]] = psrc[lx];
+            }
+        }
+    }
+    return 0;
+}
+
+
+int32_t BMP_565_TiledToLinear(uint8_t* pbmp_Dst, const BMP_565_Tiled* t)
+{
+    if (t == NULL || pbmp_Dst == NULL || BMP_565_GetWidth(pbmp_Dst) != t->width || BMP_565_GetHeight(pbmp_Dst) != t->height)
+        return -1;
+
+    uint32_t size = 1UL << t->shift;
+    for (uint32_t ty = 0; ty < t->tiles_y; ty++)
+    {
+        for (uint32_t tx = 0; tx < t->tiles_x; tx++)
+        {
+            const uint16_t* ptile = t->data + Tile_base(t, tx, ty);
+            uint32_t x0 = tx << t->shift, y0 = ty << t->shift;
+            uint32_t w  = x0 + size > t->width  ? t->width  - x0 : size;
+            uint32_t h  = y0 + size > t->height ? t->height - y0 : size;
+
+            for (uint32_t ly = 0; ly < h; ly++)
+            {
+                uint16_t* pdst = (uint16_t*)BMP_565_GetRowAddr(pbmp_Dst, y0 + ly) + x0;
+                for (uint32_t lx = 0; lx < w; lx++)
+                    pdst[lx] = ptile[t->lx[lx] + t->ly[ly]];
+            }
+        }
+    }
+
+    BMP_565_HashInvalidate(pbmp_Dst, 0, 0, t->width - 1, t->height - 1);
+    return 0;
+}
+
+
+void BMP_565_TiledFillRect(BMP_565_Tiled* t, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (t == NULL || x0 > x1 || y0 > y1 || x1 >= t->width || y1 >= t->height)
+        return;
+
+    uint16_t col  = COL_RGB565(r, g, b);
+    uint32_t mask = (1UL << t->shift) - 1;
+
+    for (uint32_t ty = y0 >> t->shift; ty <= y1 >> t->shift; ty++)
+    {
+        uint32_t ly0 = ty == y0 >> t->shift ? y0 & mask : 0;
+        uint32_t ly1 = ty == y1 >> t->shift ? y1 & mask : mask;
+
+        for (uint32_t tx = x0 >> t->shift; tx <= x1 >> t->shift; tx++)
+        {
+            uint16_t* ptile = t->data + Tile_base(t, tx, ty);
+            uint32_t  lx0 = tx == x0 >> t->shift ? x0 & mask : 0;
+            uint32_t  lx1 = tx == x1 >> t->shift ? x1 & mask : mask;
+
+            for (uint32_t ly = ly0; ly <= ly1; ly++)
+            {
+                for (uint32_t lx = lx0; lx <= lx1; lx++)
+                    ptile[t->lx[lx] + t->ly[ly]] = col;
+            }
+        }
+    }
+}
+
+
+// A column stays inside one tile per "tile size" rows instead of touching a new
+// linear row (and cache line) for every pixel
+void BMP_565_TiledVLine(BMP_565_Tiled* t, uint32_t x, uint32_t y0, uint32_t y1, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (t == NULL || x >= t->width)
+        return;
+    if (y0 > y1)
+    {
+        uint32_t swap = y0;
+        y0 = y1;
+        y1 = swap;
+    }
+    if (y1 >= t->height)
+        y1 = t->height - 1;
+    if (y0 > y1)
+        return;
+
+    uint16_t col  = COL_RGB565(r, g, b);
+    uint32_t mask = (1UL << t->shift) - 1;
+
+    for (uint32_t ty = y0 >> t->shift; ty <= y1 >> t->shift; ty++)
+    {
+        uint16_t* pcol = t->data + Tile_base(t, x >> t->shift, ty) + t->lx[x & mask];
+        uint32_t  ly0  = ty == y0 >> t->shift ? y0 & mask : 0;
+        uint32_t  ly1  = ty == y1 >> t->shift ? y1 & mask : mask;
+
+        for (uint32_t ly = ly0; ly <= ly1; ly++)
+            pcol[t->ly[ly]] = col;
+    }
+}
+
+
+// Copy "src" to (x, y) in "dst", clipped. The layouts of the two may differ.
+void BMP_565_TiledBlit(BMP_565_Tiled* dst, int32_t x, int32_t y, const BMP_565_Tiled* src)
+{
+    if (dst == NULL || src == NULL)
+        return;
+
+    int32_t col0 = x < 0 ? -x : 0;
+    int32_t row0 = y < 0 ? -y : 0;
+    int32_t col1 = x + src->width  > dst->width  ? dst->width  - x : src->width;
+    int32_t row1 = y + src->height > dst->height ? dst->height - y : src->height;
+
+    for (int32_t row = row0; row < row1; row++)
+    {
+        for (int32_t col = col0; col < col1; col++)
+            dst->data[BMP_565_TiledIndex(dst, x + col, y + row)] = src->data[BMP_565_TiledIndex(src, col, row)];
+    }
+}
+
+
+// "dst" must be src->height x src->width. Walks the destination tile by tile;
+// the matching source pixels come from a few neighbouring source tiles, so both
+// sides stay in cache, where a linear rotation strides a full row per pixel.
+int32_t BMP_565_TiledRotate90(BMP_565_Tiled* dst, const BMP_565_Tiled* src, uint8_t clockwise)
+{
+    if (dst == NULL || src == NULL || dst->width != src->height || dst->height != src->width)
+        return -1;
+
+    uint32_t size = 1UL << dst->shift;
+    for (uint32_t ty = 0; ty < dst->tiles_y; ty++)
+    {
+        for (uint32_t tx = 0; tx < dst->tiles_x; tx++)
+        {
+            uint16_t* ptile = dst->data + Tile_base(dst, tx, ty);
+            uint32_t  x0 = tx << dst->shift, y0 = ty << dst->shift;
+            uint32_t  w  = x0 + size > dst->width  ? dst->width  - x0 : size;
+            uint32_t  h  = y0 + size > dst->height ? dst->height - y0 : size;
+
+            for (uint32_t ly = 0; ly < h; ly++)
+            {
+                for (uint32_t lx = 0; lx < w; lx++)
+                {
+                    uint32_t X = x0 + lx, Y = y0 + ly;
+                    uint32_t i = clockwise ? BMP_565_TiledIndex(src, Y, src->height - 1 - X)
+                                           : BMP_565_TiledIndex(src, src->width - 1 - Y, X);
+                    ptile[dst->lx[lx] + dst->ly[ly]] = src->data[i];
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+
+// Nearest-neighbour scale of the whole of "src" onto the whole of "dst"
+void BMP_565_TiledScale(BMP_565_Tiled* dst, const BMP_565_Tiled* src)
+{
+    if (dst == NULL || src == NULL)
+        return;
+
+    uint32_t step_x = ((uint32_t)src->width  << 16) / dst->width;
+    uint32_t step_y = ((uint32_t)src->height << 16) / dst->height;
+    uint32_t size   = 1UL << dst->shift;
+
+    for (uint32_t ty = 0; ty < dst->tiles_y; ty++)
+    {
+        for (uint32_t tx = 0; tx < dst->tiles_x; tx++)
+        {
+            uint16_t* ptile = dst->data + Tile_base(dst, tx, ty);
+            uint32_t  x0 = tx << dst->shift, y0 = ty << dst->shift;
+            uint32_t  w  = x0 + size > dst->width  ? dst->width  - x0 : size;
+            uint32_t  h  = y0 + size > dst->height ? dst->height - y0 : size;
+
+            for (uint32_t ly = 0; ly < h; ly++)
+            {
+                uint32_t sy = (uint32_t)(((uint64_t)(y0 + ly) * step_y + (step_y >> 1)) >> 16);
+                for (uint32_t lx = 0; lx < w; lx++)
+                {
+                    uint32_t sx = (uint32_t)(((uint64_t)(x0 + lx) * step_x + (step_x >> 1)) >> 16);
+                    ptile[dst->lx[lx] + dst->ly[ly]] = src->data[BMP_565_TiledIndex(src, sx, sy)];
+                }
+            }
+        }
+    }
+}
+
+
+/*********************************** Private methods **********************************/
+
+static inline uint32_t Tile_base(const BMP_565_Tiled* t, uint32_t tx, uint32_t ty)
+{
+    return (ty * t->tiles_x + tx) << (t->shift << 1);
+}
+
+// 0b0000abcd -> 0b0a0b0c0d
+static inline uint32_t Spread_bits(uint32_t v)
+{
+    v = (v | (v << 2)) & 0x33;
+    v = (v | (v << 1)) & 0x55;
+    return v;
+}
@@ -107,18 +107,22 @@ int main(void)
     
     /* Configure LCD */
     LCD_Config();
+
+    /* DMA2D engine: before the first BSP fill, which borrows the DMA2D from it */
+    BMP_565_AsyncInit();
     
     /* Configure TS module */
     TS_Config();
 
     /* uGUI Init */
     UG_Init(&gui, (void (*)(UG_S16, UG_S16, UG_COLOR)) pset, BSP_LCD_GetXSize(), BSP_LCD_GetYSize());
+    /* uGUI draws straight into layer 0 (ARGB8888) */
+    UG_SurfaceRegister((void*) LCD_FB_START_ADDRESS, BSP_LCD_GetXSize() * 4, SURFACE_FORMAT_ARGB8888);
     UG_FillScreen(C_WHITE);
 
     /* uGUI hardware accelerator */
-    UG_DriverRegister(DRIVER_DRAW_LINE, (void*) _HW_DrawLine);
+    /* Lines are left to the surface: BSP_LCD_DrawLine() plots pixel by pixel */
     UG_DriverRegister(DRIVER_FILL_FRAME, (void*) _HW_FillFrame);
-    UG_DriverEnable(DRIVER_DRAW_LINE);
     UG_DriverEnable(DRIVER_FILL_FRAME);
     
     /* FreeRTOS : Start task */
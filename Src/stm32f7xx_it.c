@@ -41,6 +41,7 @@
 #include "main.h"
 #include "stm32f7xx_it.h"
 #include "cmsis_os.h"
+#include "bmp_rgb565_async.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -157,4 +158,14 @@ void EXTI15_10_IRQHandler(void)
 	HAL_GPIO_EXTI_IRQHandler(TS_INT_PIN);
 }
 
+/**
+  * @brief  This function handles DMA2D interrupt request.
+  * @param  None
+  * @retval None
+  */
+void DMA2D_IRQHandler(void)
+{
+	BMP_565_AsyncIRQHandler();
+}
+
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
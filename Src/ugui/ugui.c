@@ -29,18 +29,62 @@
 //  Oct 11, 2014  V0.1  First release.
 /* -------------------------------------------------------------------------------- */
 #include "ugui.h"
+#include <string.h>
 
 /* Static functions */
  UG_RESULT _UG_WindowDrawTitle( UG_WINDOW* wnd );
  void _UG_WindowUpdate( UG_WINDOW* wnd );
+ void _UG_WindowRenderDirty( UG_WINDOW* wnd );
+ UG_U8 _UG_AreaIntersect( UG_AREA* a, UG_AREA* b, UG_AREA* r );
+ UG_S32 _UG_AreaMergeCost( UG_AREA* a, UG_AREA* b );
+ void _UG_FillOutside( UG_AREA* r, UG_AREA* a, UG_COLOR c );
  UG_RESULT _UG_WindowClear( UG_WINDOW* wnd );
  void _UG_TextboxUpdate(UG_WINDOW* wnd, UG_OBJECT* obj);
+ void _UG_TextboxGetText( UG_OBJECT* obj, UG_TEXTBOX* txb, UG_TEXT* txt );
+ UG_RESULT _UG_TextboxUpdateText( UG_OBJECT* obj, UG_TEXTBOX* txb );
+ void _UG_TextboxSaveText( UG_TEXTBOX* txb );
  void _UG_ButtonUpdate(UG_WINDOW* wnd, UG_OBJECT* obj);
  void _UG_ImageUpdate(UG_WINDOW* wnd, UG_OBJECT* obj);
+ void _UG_PutPixel( UG_S16 x, UG_S16 y, UG_COLOR c );
+ void _UG_HLine( UG_S16 x1, UG_S16 x2, UG_S16 y, UG_COLOR c );
+ void _UG_VLine( UG_S16 x, UG_S16 y1, UG_S16 y2, UG_COLOR c );
+ void _UG_PutGlyph( unsigned char* p, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc, UG_COLOR bc );
+ void _UG_PutGlyphTransparent( unsigned char* p, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc );
+ unsigned char* _UG_GetGlyph( unsigned char* font, UG_S16 w, UG_S16 h, char chr );
+ void _UG_TextLayout( UG_TEXT* txt, UG_TEXT_LAYOUT* l );
+ void _UG_PutTextChar( UG_TEXT* txt, char chr, UG_S16 x, UG_S16 y );
+ UG_U8 _UG_BMPFormat( UG_BMP* bmp );
+ UG_S32 _UG_BMPStride( UG_BMP* bmp, UG_U8 fmt );
+ UG_COLOR _UG_BMPGetPixel( const UG_U8* s, UG_U8 fmt, UG_S16 x );
+ void _UG_BlitRow565( UG_U16* d, const UG_U8* s, UG_U8 fmt, UG_S16 x, UG_S16 n );
+ void _UG_BlitRow8888( UG_U32* d, const UG_U8* s, UG_U8 fmt, UG_S16 x, UG_S16 n );
+#ifdef USE_GLYPH_CACHE
+ UG_U8* _UG_GlyphCacheGet( unsigned char* p, UG_S16 w, UG_S16 h );
+ void _UG_PutGlyphRuns( UG_U8* r, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc, UG_COLOR bc );
+ void _UG_PutGlyphRunsTransparent( UG_U8* r, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc );
+#endif
 
  /* Pointer to the gui */
 static UG_GUI* gui;
 
+/* Is (x,y) inside the clip area? */
+#define _UG_CLIP_INSIDE(x,y)      (((x) >= gui->clip.a.xs) && ((x) <= gui->clip.a.xe) && ((y) >= gui->clip.a.ys) && ((y) <= gui->clip.a.ye))
+
+#ifdef USE_GLYPH_CACHE
+/* Glyphs as run lengths, alternating background and foreground and starting */
+/* with background, row after row. Colours are applied when drawing, so the   */
+/* glyph bitmap address alone (font + character) is the key.                 */
+typedef struct
+{
+   unsigned char* p;
+   UG_U32 used;
+   UG_U8 runs[GLYPH_CACHE_ENTRY_SIZE];
+} UG_GLYPH_CACHE_ENTRY;
+
+static UG_GLYPH_CACHE_ENTRY glyph_cache[GLYPH_CACHE_ENTRIES];
+static UG_U32 glyph_cache_clock;
+#endif
+
 #ifdef USE_FONT_4X6
 __UG_CONST unsigned char font_4x6[256][6]={
 {0x00,0x00,0x00,0x00,0x00,0x00}, // 0x00
@@ -4284,9 +4328,10 @@ UG_S16 UG_Init( UG_GUI* g, void (*p)(UG_S16,UG_S16,UG_COLOR), UG_S16 x, UG_S16 y
    g->font.char_h_space = 1;
    g->font.char_v_space = 1;
    g->font.p = NULL;
-   g->desktop_color = 0x5E8BEf;
+   g->desktop_color = UG_RGB(0x5E8BEF);
    g->fore_color = C_WHITE;
    g->back_color = C_BLACK;
+   g->transparent_font = 0;
    g->next_window = NULL;
    g->active_window = NULL;
    g->last_window = NULL;
@@ -4298,10 +4343,103 @@ UG_S16 UG_Init( UG_GUI* g, void (*p)(UG_S16,UG_S16,UG_COLOR), UG_S16 x, UG_S16 y
       g->driver[i].state = 0;
    }
 
+   /* No surface: draw through pset() */
+   g->surface.p = NULL;
+   g->surface.stride = 0;
+   g->surface.format = SURFACE_FORMAT_NONE;
+
+   g->dirty.count = 0;
+
+   /* Clip to the screen */
+   g->clip.a.xs = 0;
+   g->clip.a.ys = 0;
+   g->clip.a.xe = x - 1;
+   g->clip.a.ye = y - 1;
+   g->clip.depth = 0;
+
    gui = g;
    return 1;
 }
 
+void _UG_TextboxGetText( UG_OBJECT* obj, UG_TEXTBOX* txb, UG_TEXT* txt )
+{
+   txt->str = txb->str;
+   txt->font = txb->font;
+   txt->a = obj->a_abs;
+   txt->fc = txb->fc;
+   txt->bc = txb->bc;
+   txt->align = txb->align;
+   txt->h_space = txb->h_space;
+   txt->v_space = txb->v_space;
+   txt->transparent = 0;
+   txt->layout = &txb->layout;
+}
+
+/* Redraw the character cells that differ from the saved text. Fails when  */
+/* the text on screen is unknown, the layout changed or cells overlap.     */
+UG_RESULT _UG_TextboxUpdateText( UG_OBJECT* obj, UG_TEXTBOX* txb )
+{
+   UG_TEXT txt;
+   UG_TEXT_LAYOUT l;
+   UG_U16 i,n;
+   UG_S16 xp,yp;
+   char* c;
+   char* o;
+
+   if ( !(txb->state & TXB_STATE_SAVED) || !txb->layout.valid ) return UG_RESULT_FAIL;
+   if ( (txb->str == NULL) || (txb->h_space < 0) || (txb->v_space < 0) ) return UG_RESULT_FAIL;
+
+   _UG_TextboxGetText(obj, txb, &txt);
+   _UG_TextLayout(&txt, &l);
+   if ( !l.valid || (l.w != txb->layout.w) || (l.h != txb->layout.h) ) return UG_RESULT_FAIL;
+   if ( (l.lines != txb->layout.lines) || (l.yp != txb->layout.yp) ) return UG_RESULT_FAIL;
+   for( i=0;i<l.lines;i++ )
+   {
+      if ( (l.len[i] != txb->layout.len[i]) || (l.xp[i] != txb->layout.xp[i]) ) return UG_RESULT_FAIL;
+   }
+
+   /* Same cells: the background of each redrawn cell is drawn with it */
+   c = txb->str;
+   o = txb->saved;
+   yp = txt.a.ys + l.yp;
+   for( i=0;i<l.lines;i++ )
+   {
+      xp = txt.a.xs + l.xp[i];
+      for( n=0;n<l.len[i];n++ )
+      {
+         if ( *c != *o ) _UG_PutTextChar(&txt, *c, xp, yp);
+         xp += txt.font->char_width + txt.h_space;
+         c++;
+         o++;
+      }
+      c++;
+      o++;
+      yp += txt.font->char_height + txt.v_space;
+   }
+   txb->layout = l;
+   _UG_TextboxSaveText(txb);
+
+   return UG_RESULT_OK;
+}
+
+/* Keep a copy of the text on screen, if it fits */
+void _UG_TextboxSaveText( UG_TEXTBOX* txb )
+{
+   UG_U16 i;
+
+   txb->state &= ~TXB_STATE_SAVED;
+   if ( txb->str == NULL ) return;
+   for( i=0;i<TEXTBOX_SAVED_TEXT_LEN;i++ )
+   {
+      txb->saved[i] = txb->str[i];
+      if ( txb->str[i] == 0 )
+      {
+         txb->state |= TXB_STATE_SAVED;
+         return;
+      }
+   }
+}
+
 UG_S16 UG_SelectGUI( UG_GUI* g )
 {
    gui = g;
@@ -4337,6 +4475,12 @@ void UG_FillFrame( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
       y1 = n;
    }
 
+   if ( x1 < gui->clip.a.xs ) x1 = gui->clip.a.xs;
+   if ( y1 < gui->clip.a.ys ) y1 = gui->clip.a.ys;
+   if ( x2 > gui->clip.a.xe ) x2 = gui->clip.a.xe;
+   if ( y2 > gui->clip.a.ye ) y2 = gui->clip.a.ye;
+   if ( (x1 > x2) || (y1 > y2) ) return;
+
    /* Is hardware acceleration available? */
    if ( gui->driver[DRIVER_FILL_FRAME].state & DRIVER_ENABLED )
    {
@@ -4345,10 +4489,7 @@ void UG_FillFrame( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
 
    for( m=y1; m<=y2; m++ )
    {
-      for( n=x1; n<=x2; n++ )
-      {
-         gui->pset(n,m,c);
-      }
+      _UG_HLine(x1,x2,m,c);
    }
 }
 
@@ -4381,13 +4522,13 @@ void UG_FillRoundFrame( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_S16 r, UG
    {
      if( y > 0 )
      {
-        UG_DrawLine(x2 + x - r, y1 - y + r, x2+ x - r, y + y2 - r, c);
-        UG_DrawLine(x1 - x + r, y1 - y + r, x1- x + r, y + y2 - r, c);
+        _UG_VLine(x2 + x - r, y1 - y + r, y + y2 - r, c);
+        _UG_VLine(x1 - x + r, y1 - y + r, y + y2 - r, c);
      }
      if( x > 0 )
      {
-        UG_DrawLine(x1 - y + r, y1 - x + r, x1 - y + r, x + y2 - r, c);
-        UG_DrawLine(x2 + y - r, y1 - x + r, x2 + y - r, x + y2 - r, c);
+        _UG_VLine(x1 - y + r, y1 - x + r, x + y2 - r, c);
+        _UG_VLine(x2 + y - r, y1 - x + r, x + y2 - r, c);
      }
      if ( xd < 0 )
      {
@@ -4423,7 +4564,7 @@ void UG_DrawMesh( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
    {
       for( n=x1; n<=x2; n+=2 )
       {
-         gui->pset(n,m,c);
+         _UG_PutPixel(n,m,c);
       }
    }
 }
@@ -4467,7 +4608,7 @@ void UG_DrawRoundFrame( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_S16 r, UG
 
 void UG_DrawPixel( UG_S16 x0, UG_S16 y0, UG_COLOR c )
 {
-   gui->pset(x0,y0,c);
+   _UG_PutPixel(x0,y0,c);
 }
 
 void UG_DrawCircle( UG_S16 x0, UG_S16 y0, UG_S16 r, UG_COLOR c )
@@ -4486,14 +4627,14 @@ void UG_DrawCircle( UG_S16 x0, UG_S16 y0, UG_S16 r, UG_COLOR c )
 
    while ( x >= y )
    {
-      gui->pset(x0 - x, y0 + y, c);
-      gui->pset(x0 - x, y0 - y, c);
-      gui->pset(x0 + x, y0 + y, c);
-      gui->pset(x0 + x, y0 - y, c);
-      gui->pset(x0 - y, y0 + x, c);
-      gui->pset(x0 - y, y0 - x, c);
-      gui->pset(x0 + y, y0 + x, c);
-      gui->pset(x0 + y, y0 - x, c);
+      _UG_PutPixel(x0 - x, y0 + y, c);
+      _UG_PutPixel(x0 - x, y0 - y, c);
+      _UG_PutPixel(x0 + x, y0 + y, c);
+      _UG_PutPixel(x0 + x, y0 - y, c);
+      _UG_PutPixel(x0 - y, y0 + x, c);
+      _UG_PutPixel(x0 - y, y0 - x, c);
+      _UG_PutPixel(x0 + y, y0 + x, c);
+      _UG_PutPixel(x0 + y, y0 - x, c);
 
       y++;
       e += yd;
@@ -4523,13 +4664,13 @@ void UG_FillCircle( UG_S16 x0, UG_S16 y0, UG_S16 r, UG_COLOR c )
    {
      if( y > 0 )
      {
-        UG_DrawLine(x0 - x, y0 - y,x0 - x, y0 + y, c);
-        UG_DrawLine(x0 + x, y0 - y,x0 + x, y0 + y, c);
+        _UG_VLine(x0 - x, y0 - y, y0 + y, c);
+        _UG_VLine(x0 + x, y0 - y, y0 + y, c);
      }
      if( x > 0 )
      {
-        UG_DrawLine(x0 - y, y0 - x,x0 - y, y0 + x, c);
-        UG_DrawLine(x0 + y, y0 - x,x0 + y, y0 + x, c);
+        _UG_VLine(x0 - y, y0 - x, y0 + x, c);
+        _UG_VLine(x0 + y, y0 - x, y0 + x, c);
      }
      if ( xd < 0 )
      {
@@ -4562,20 +4703,20 @@ void UG_DrawArc( UG_S16 x0, UG_S16 y0, UG_S16 r, UG_U8 s, UG_COLOR c )
    while ( x >= y )
    {
       // Q1
-      if ( s & 0x01 ) gui->pset(x0 + x, y0 - y, c);
-      if ( s & 0x02 ) gui->pset(x0 + y, y0 - x, c);
+      if ( s & 0x01 ) _UG_PutPixel(x0 + x, y0 - y, c);
+      if ( s & 0x02 ) _UG_PutPixel(x0 + y, y0 - x, c);
 
       // Q2
-      if ( s & 0x04 ) gui->pset(x0 - y, y0 - x, c);
-      if ( s & 0x08 ) gui->pset(x0 - x, y0 - y, c);
+      if ( s & 0x04 ) _UG_PutPixel(x0 - y, y0 - x, c);
+      if ( s & 0x08 ) _UG_PutPixel(x0 - x, y0 - y, c);
 
       // Q3
-      if ( s & 0x10 ) gui->pset(x0 - x, y0 + y, c);
-      if ( s & 0x20 ) gui->pset(x0 - y, y0 + x, c);
+      if ( s & 0x10 ) _UG_PutPixel(x0 - x, y0 + y, c);
+      if ( s & 0x20 ) _UG_PutPixel(x0 - y, y0 + x, c);
 
       // Q4
-      if ( s & 0x40 ) gui->pset(x0 + y, y0 + x, c);
-      if ( s & 0x80 ) gui->pset(x0 + x, y0 + y, c);
+      if ( s & 0x40 ) _UG_PutPixel(x0 + y, y0 + x, c);
+      if ( s & 0x80 ) _UG_PutPixel(x0 + x, y0 + y, c);
 
       y++;
       e += yd;
@@ -4606,12 +4747,24 @@ void UG_DrawLine( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
       y1 = n;
    }*/
 
-   /* Is hardware acceleration available? */
-   if ( gui->driver[DRIVER_DRAW_LINE].state & DRIVER_ENABLED )
+   /* Is hardware acceleration available? Only for lines inside the clip area */
+   if ( (gui->driver[DRIVER_DRAW_LINE].state & DRIVER_ENABLED) && _UG_CLIP_INSIDE(x1,y1) && _UG_CLIP_INSIDE(x2,y2) )
    {
       if( ((UG_RESULT(*)(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c))gui->driver[DRIVER_DRAW_LINE].driver)(x1,y1,x2,y2,c) == UG_RESULT_OK ) return;
    }
 
+   /* Horizontal and vertical lines are spans */
+   if ( y1 == y2 )
+   {
+      _UG_HLine(x1,x2,y1,c);
+      return;
+   }
+   if ( x1 == x2 )
+   {
+      _UG_VLine(x1,y1,y2,c);
+      return;
+   }
+
    dx = x2 - x1;
    dy = y2 - y1;
    dxabs = (dx>0)?dx:-dx;
@@ -4623,7 +4776,7 @@ void UG_DrawLine( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
    drawx = x1;
    drawy = y1;
 
-   gui->pset(drawx, drawy,c);
+   _UG_PutPixel(drawx, drawy,c);
 
    if( dxabs >= dyabs )
    {
@@ -4636,7 +4789,7 @@ void UG_DrawLine( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
             drawy += sgndy;
          }
          drawx += sgndx;
-         gui->pset(drawx, drawy,c);
+         _UG_PutPixel(drawx, drawy,c);
       }
    }
    else
@@ -4650,7 +4803,76 @@ void UG_DrawLine( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
             drawx += sgndx;
          }
          drawy += sgndy;
-         gui->pset(drawx, drawy,c);
+         _UG_PutPixel(drawx, drawy,c);
+      }
+   }
+}
+
+void UG_BlendFrame( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c, UG_U8 alpha )
+{
+   UG_S16 n,m;
+   UG_U32 a,rb,g,d;
+   UG_U8* line;
+
+   if ( x2 < x1 )
+   {
+      n = x2;
+      x2 = x1;
+      x1 = n;
+   }
+   if ( y2 < y1 )
+   {
+      n = y2;
+      y2 = y1;
+      y1 = n;
+   }
+   if ( alpha == 0 ) return;
+
+   if ( x1 < gui->clip.a.xs ) x1 = gui->clip.a.xs;
+   if ( y1 < gui->clip.a.ys ) y1 = gui->clip.a.ys;
+   if ( x2 > gui->clip.a.xe ) x2 = gui->clip.a.xe;
+   if ( y2 > gui->clip.a.ye ) y2 = gui->clip.a.ye;
+   if ( (x1 > x2) || (y1 > y2) ) return;
+
+   /* Is hardware acceleration available? */
+   if ( gui->driver[DRIVER_BLEND_FRAME].state & DRIVER_ENABLED )
+   {
+      if( ((UG_RESULT(*)(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c, UG_U8 alpha))gui->driver[DRIVER_BLEND_FRAME].driver)(x1,y1,x2,y2,c,alpha) == UG_RESULT_OK ) return;
+   }
+
+   /* Blending reads the framebuffer: without a surface only an opaque fill is possible */
+   if ( (alpha == 0xFF) || (gui->surface.format == SURFACE_FORMAT_NONE) )
+   {
+      if ( alpha >= 0x80 ) UG_FillFrame(x1,y1,x2,y2,c);
+      return;
+   }
+
+   /* d + (c - d) * a / 256 on R|B and G at once, a = 1..256 */
+   a = (UG_U32)alpha + 1;
+   d = UG_COLOR_TO_RGB888(c);
+   rb = (d & 0xFF00FF) * a;
+   g = (d & 0x00FF00) * a;
+   a = 256 - a;
+
+   for( m=y1; m<=y2; m++ )
+   {
+      line = (UG_U8*)gui->surface.p + (UG_S32)m * gui->surface.stride;
+      for( n=x1; n<=x2; n++ )
+      {
+         if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+         {
+            d = ((UG_U16*)line)[n];
+            d = ((d & 0xF800) << 8) | ((d & 0x07E0) << 5) | ((d & 0x001F) << 3);
+         }
+         else
+         {
+            d = ((UG_U32*)line)[n];
+         }
+         d = ((((d & 0xFF00FF) * a + rb) >> 8) & 0xFF00FF) | ((((d & 0x00FF00) * a + g) >> 8) & 0x00FF00);
+         if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+            ((UG_U16*)line)[n] = (UG_U16)(((d >> 8) & 0xF800) | ((d >> 5) & 0x07E0) | ((d >> 3) & 0x001F));
+         else
+            ((UG_U32*)line)[n] = 0xFF000000 | d;
       }
    }
 }
@@ -4659,6 +4881,7 @@ void UG_PutString( UG_S16 x, UG_S16 y, char* str )
 {
    UG_S16 xp,yp;
    char chr;
+   unsigned char* p;
 
    xp=x;
    yp=y;
@@ -4679,7 +4902,15 @@ void UG_PutString( UG_S16 x, UG_S16 y, char* str )
          yp += gui->font.char_height+gui->font.char_v_space;
       }
 
-      UG_PutChar(chr, xp, yp, gui->fore_color, gui->back_color);
+      if ( gui->transparent_font )
+      {
+         p = _UG_GetGlyph(gui->font.p, gui->font.char_width, gui->font.char_height, chr);
+         if ( p != NULL ) _UG_PutGlyphTransparent(p, xp, yp, gui->font.char_width, gui->font.char_height, gui->fore_color);
+      }
+      else
+      {
+         UG_PutChar(chr, xp, yp, gui->fore_color, gui->back_color);
+      }
 
       xp += gui->font.char_width+gui->font.char_h_space;
       str++;
@@ -4688,56 +4919,12 @@ void UG_PutString( UG_S16 x, UG_S16 y, char* str )
 
 void UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc )
 {
-   UG_U16 i,j,k,xo,yo,c,bn;
-   UG_U8 b,bt;
    unsigned char* p;
 
-   bt = (UG_U8)chr;
-
-   switch ( bt )
-   {
-      case 0xF6: bt = 0x94; break; // �
-      case 0xD6: bt = 0x99; break; // ﾖ
-      case 0xFC: bt = 0x81; break; // �
-      case 0xDC: bt = 0x9A; break; // ﾜ
-      case 0xE4: bt = 0x84; break; // �
-      case 0xC4: bt = 0x8E; break; // ﾄ
-      case 0xB5: bt = 0xE6; break; // ｵ
-      case 0xB0: bt = 0xF8; break; // ｰ
-   }
-
-   yo = y;
-   bn = gui->font.char_width;
-   if ( !bn ) return;
-   bn >>= 3;
-   if ( gui->font.char_width % 8 ) bn++;
-   p = gui->font.p;
-   p+= bt * gui->font.char_height * bn;
+   p = _UG_GetGlyph(gui->font.p, gui->font.char_width, gui->font.char_height, chr);
+   if ( p == NULL ) return;
 
-   for( j=0;j<gui->font.char_height;j++ )
-   {
-      xo = x;
-      c=gui->font.char_width;
-      for( i=0;i<bn;i++ )
-      {
-         b = *p++;
-         for( k=0;(k<8) && c;k++ )
-         {
-            if( b & 0x01 )
-            {
-               gui->pset(xo,yo,fc);
-            }
-            else
-            {
-               gui->pset(xo,yo,bc);
-            }
-            b >>= 1;
-            xo++;
-            c--;
-         }
-      }
-      yo++;
-   }
+   _UG_PutGlyph(p, x, y, gui->font.char_width, gui->font.char_height, fc, bc);
 }
 
 void UG_ConsolePutString( char* str )
@@ -4821,64 +5008,69 @@ void UG_FontSetVSpace( UG_U16 s )
    gui->font.char_v_space = s;
 }
 
+void UG_FontSetTransparency( UG_U8 t )
+{
+   gui->transparent_font = t;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 const UG_COLOR pal_window[] =
 {
    /* Frame 0 */
-   0x646464,
-   0x646464,
-   0x646464,
-   0x646464,
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
    /* Frame 1 */
-   0xFFFFFF,
-   0xFFFFFF,
-   0x696969,
-   0x696969,
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0x696969),
+   UG_RGB(0x696969),
    /* Frame 2 */
-   0xE3E3E3,
-   0xE3E3E3,
-   0xA0A0A0,
-   0xA0A0A0,
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
 };
 
 const UG_COLOR pal_button_pressed[] =
 {
    /* Frame 0 */
-   0x646464,
-   0x646464,
-   0x646464,
-   0x646464,
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
    /* Frame 1 */
-   0xA0A0A0,
-   0xA0A0A0,
-   0xA0A0A0,
-   0xA0A0A0,
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
    /* Frame 2 */
-   0xF0F0F0,
-   0xF0F0F0,
-   0xF0F0F0,
-   0xF0F0F0,
+   UG_RGB(0xF0F0F0),
+   UG_RGB(0xF0F0F0),
+   UG_RGB(0xF0F0F0),
+   UG_RGB(0xF0F0F0),
 };
 
 const UG_COLOR pal_button_released[] =
 {
    /* Frame 0 */
-   0x646464,
-   0x646464,
-   0x646464,
-   0x646464,
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
    /* Frame 1 */
-   0xFFFFFF,
-   0xFFFFFF,
-   0x696969,
-   0x696969,
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0x696969),
+   UG_RGB(0x696969),
    /* Frame 2 */
-   0xE3E3E3,
-   0xE3E3E3,
-   0xA0A0A0,
-   0xA0A0A0,
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
 };
 /* -------------------------------------------------------------------------------- */
 /* -- INTERNAL FUNCTIONS                                                         -- */
@@ -4896,10 +5088,8 @@ void _UG_PutText(UG_TEXT* txt)
    UG_S16 char_height=txt->font->char_height;
    UG_S16 char_h_space=txt->h_space;
    UG_S16 char_v_space=txt->v_space;
-   UG_U16 i,j,k,xo,yo,cw,bn;
-   UG_U8  b,bt;
-
-   unsigned char* p;
+   UG_TEXT_LAYOUT* l=txt->layout;
+   UG_U16 i,n;
 
    char* str = txt->str;
    char* c = str;
@@ -4908,6 +5098,28 @@ void _UG_PutText(UG_TEXT* txt)
    if ( str == NULL ) return;
    if ( (ye - ys) < txt->font->char_height ) return;
 
+   /* Draw from the object's layout, (re)built if needed */
+   if ( l != NULL )
+   {
+      if ( !l->valid || (l->w != xe - xs) || (l->h != ye - ys) ) _UG_TextLayout(txt, l);
+      if ( l->valid )
+      {
+         yp = ys + l->yp;
+         for( i=0;i<l->lines;i++ )
+         {
+            xp = xs + l->xp[i];
+            for( n=0;n<l->len[i];n++ )
+            {
+               _UG_PutTextChar(txt, *c++, xp, yp);
+               xp += char_width + char_h_space;
+            }
+            c++;
+            yp += char_height + char_v_space;
+         }
+         return;
+      }
+   }
+
    rc=1;
    c=str;
    while ( *c != 0 )
@@ -4949,52 +5161,7 @@ void _UG_PutText(UG_TEXT* txt)
       while( (*str != '\n') )
       {
          if ( *str == 0 ) return;
-         /*----------------------------------*/
-         /* Draw one char                    */
-         /*----------------------------------*/
-         bt = (UG_U8)*str;
-         switch ( bt )
-         {
-            case 0xF6: bt = 0x94; break; // �
-            case 0xD6: bt = 0x99; break; // ﾖ
-            case 0xFC: bt = 0x81; break; // �
-            case 0xDC: bt = 0x9A; break; // ﾜ
-            case 0xE4: bt = 0x84; break; // �
-            case 0xC4: bt = 0x8E; break; // ﾄ
-            case 0xB5: bt = 0xE6; break; // ｵ
-            case 0xB0: bt = 0xF8; break; // ｰ
-         }
-         yo = yp;
-         bn = char_width;
-         bn >>= 3;
-         if ( char_width % 8 ) bn++;
-         p = txt->font->p;
-         p+= bt * char_height * bn;
-         for( j=0;j<char_height;j++ )
-         {
-            xo = xp;
-            cw=char_width;
-            for( i=0;i<bn;i++ )
-            {
-               b = *p++;
-               for( k=0;(k<8) && cw;k++ )
-               {
-                  if( b & 0x01 )
-                  {
-                     gui->pset(xo,yo,txt->fc);
-                  }
-                  else
-                  {
-                     gui->pset(xo,yo,txt->bc);
-                  }
-                  b >>= 1;
-                  xo++;
-                  cw--;
-               }
-            }
-            yo++;
-         }
-         /*----------------------------------*/
+         _UG_PutTextChar(txt, *str, xp, yp);
          xp += char_width + char_h_space;
          str++;
       }
@@ -5003,6 +5170,89 @@ void _UG_PutText(UG_TEXT* txt)
    }
 }
 
+/* Same placement as _UG_PutText. Texts with more than TEXT_LAYOUT_MAX_LINES */
+/* lines are left invalid and laid out while drawing.                       */
+void _UG_TextLayout( UG_TEXT* txt, UG_TEXT_LAYOUT* l )
+{
+   UG_U16 i,sl,rc;
+   UG_S16 xp,yp,w;
+   UG_S16 xs=txt->a.xs;
+   UG_S16 ys=txt->a.ys;
+   UG_S16 xe=txt->a.xe;
+   UG_S16 ye=txt->a.ye;
+   UG_U8  align=txt->align;
+   UG_S16 char_width=txt->font->char_width;
+   UG_S16 char_height=txt->font->char_height;
+   UG_S16 char_h_space=txt->h_space;
+   UG_S16 char_v_space=txt->v_space;
+   char* c;
+
+   l->valid = 0;
+   l->lines = 0;
+   l->w = xe - xs;
+   l->h = ye - ys;
+   l->yp = 0;
+   l->width = 0;
+
+   rc=1;
+   c=txt->str;
+   while ( *c != 0 )
+   {
+      if ( *c == '\n' ) rc++;
+      c++;
+   }
+   if ( rc > TEXT_LAYOUT_MAX_LINES ) return;
+
+   l->height = char_height*rc + char_v_space*(rc-1);
+   l->valid = 1;
+
+   yp = 0;
+   if ( align & (ALIGN_V_CENTER | ALIGN_V_BOTTOM) )
+   {
+      yp = ye - ys + 1;
+      yp -= l->height;
+      if ( yp < 0 ) return;
+   }
+   if ( align & ALIGN_V_CENTER ) yp >>= 1;
+   l->yp = yp;
+
+   c=txt->str;
+   for( i=0;i<rc;i++ )
+   {
+      sl=0;
+      while( (*c != 0) && (*c != '\n') )
+      {
+         c++;
+         sl++;
+      }
+
+      w = char_width*sl + char_h_space*(sl-1);
+      xp = xe - xs + 1;
+      xp -= w;
+      if ( xp < 0 ) return;
+
+      if ( align & ALIGN_H_LEFT ) xp = 0;
+      else if ( align & ALIGN_H_CENTER ) xp >>= 1;
+
+      l->xp[i] = xp;
+      l->len[i] = sl;
+      l->lines++;
+      if ( sl && (w > l->width) ) l->width = w;
+      c++;
+   }
+}
+
+void _UG_PutTextChar( UG_TEXT* txt, char chr, UG_S16 x, UG_S16 y )
+{
+   unsigned char* p;
+
+   p = _UG_GetGlyph(txt->font->p, txt->font->char_width, txt->font->char_height, chr);
+   if ( p == NULL ) return;
+
+   if ( txt->transparent ) _UG_PutGlyphTransparent(p, x, y, txt->font->char_width, txt->font->char_height, txt->fc);
+   else _UG_PutGlyph(p, x, y, txt->font->char_width, txt->font->char_height, txt->fc, txt->bc);
+}
+
 UG_OBJECT* _UG_GetFreeObject( UG_WINDOW* wnd )
 {
    UG_U8 i;
@@ -5141,6 +5391,11 @@ void _UG_UpdateObjects( UG_WINDOW* wnd )
    UG_OBJECT* obj;
    UG_U8 objstate;
    UG_U8 objtouch;
+   UG_AREA a;
+
+   /* Objects are clipped to the window area */
+   UG_WindowGetArea(wnd,&a);
+   if ( UG_ClipPush(a.xs,a.ys,a.xe,a.ye) != UG_RESULT_OK ) return;
 
    /* Check each object, if it needs to be updated? */
    objcnt = wnd->objcnt;
@@ -5164,6 +5419,7 @@ void _UG_UpdateObjects( UG_WINDOW* wnd )
          }
       }
    }
+   UG_ClipPop();
 }
 
 void _UG_HandleEvents( UG_WINDOW* wnd )
@@ -5204,68 +5460,740 @@ void _UG_HandleEvents( UG_WINDOW* wnd )
 void _UG_DrawObjectFrame( UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S16 ye, UG_COLOR* p )
 {
    // Frame 0
-   UG_DrawLine(xs, ys  , xe-1, ys  , *p++);
-   UG_DrawLine(xs, ys+1, xs  , ye-1, *p++);
-   UG_DrawLine(xs, ye  , xe  , ye  , *p++);
-   UG_DrawLine(xe, ys  , xe  , ye-1, *p++);
+   _UG_HLine(xs  , xe-1, ys  , *p++);
+   _UG_VLine(xs  , ys+1, ye-1, *p++);
+   _UG_HLine(xs  , xe  , ye  , *p++);
+   _UG_VLine(xe  , ys  , ye-1, *p++);
    // Frame 1
-   UG_DrawLine(xs+1, ys+1, xe-2, ys+1, *p++);
-   UG_DrawLine(xs+1, ys+2, xs+1, ye-2, *p++);
-   UG_DrawLine(xs+1, ye-1, xe-1, ye-1, *p++);
-   UG_DrawLine(xe-1, ys+1, xe-1, ye-2, *p++);
+   _UG_HLine(xs+1, xe-2, ys+1, *p++);
+   _UG_VLine(xs+1, ys+2, ye-2, *p++);
+   _UG_HLine(xs+1, xe-1, ye-1, *p++);
+   _UG_VLine(xe-1, ys+1, ye-2, *p++);
    // Frame 2
-   UG_DrawLine(xs+2, ys+2, xe-3, ys+2, *p++);
-   UG_DrawLine(xs+2, ys+3, xs+2, ye-3, *p++);
-   UG_DrawLine(xs+2, ye-2, xe-2, ye-2, *p++);
-   UG_DrawLine(xe-2, ys+2, xe-2, ye-3, *p);
+   _UG_HLine(xs+2, xe-3, ys+2, *p++);
+   _UG_VLine(xs+2, ys+3, ye-3, *p++);
+   _UG_HLine(xs+2, xe-2, ye-2, *p++);
+   _UG_VLine(xe-2, ys+2, ye-3, *p);
 }
 
-/* -------------------------------------------------------------------------------- */
-/* -- DRIVER FUNCTIONS                                                           -- */
-/* -------------------------------------------------------------------------------- */
-void UG_DriverRegister( UG_U8 type, void* driver )
-{
-   if ( type >= NUMBER_OF_DRIVERS ) return;
-
-   gui->driver[type].driver = driver;
-   gui->driver[type].state = DRIVER_REGISTERED | DRIVER_ENABLED;
-}
+/* UG_COLOR in the surface's pixel format: a plain cast for a matching RGB565, alpha forced opaque for ARGB8888 */
+#if UG_COLOR_FORMAT == UG_COLOR_RGB565
+#define _UG_SURFACE_RGB565(c)     (UG_U16)(c)
+#else
+#define _UG_SURFACE_RGB565(c)     (UG_U16)((((c)>>8)&0xF800) | (((c)>>5)&0x07E0) | (((c)>>3)&0x001F))
+#endif
+#define _UG_SURFACE_ARGB8888(c)   (UG_U32)UG_COLOR_TO_ARGB8888(c)
+#define _UG_SURFACE_LINE(y)       ((UG_U8*)gui->surface.p + (UG_S32)(y) * gui->surface.stride)
 
-void UG_DriverEnable( UG_U8 type )
+void _UG_PutPixel( UG_S16 x, UG_S16 y, UG_COLOR c )
 {
-   if ( type >= NUMBER_OF_DRIVERS ) return;
-   if ( gui->driver[type].state & DRIVER_REGISTERED )
+   if ( !_UG_CLIP_INSIDE(x,y) ) return;
+
+   if ( gui->surface.format == SURFACE_FORMAT_NONE )
    {
-      gui->driver[type].state |= DRIVER_ENABLED;
+      gui->pset(x,y,c);
+      return;
    }
+
+   if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+      ((UG_U16*)_UG_SURFACE_LINE(y))[x] = _UG_SURFACE_RGB565(c);
+   else
+      ((UG_U32*)_UG_SURFACE_LINE(y))[x] = _UG_SURFACE_ARGB8888(c);
 }
 
-void UG_DriverDisable( UG_U8 type )
+void _UG_HLine( UG_S16 x1, UG_S16 x2, UG_S16 y, UG_COLOR c )
 {
-   if ( type >= NUMBER_OF_DRIVERS ) return;
-   if ( gui->driver[type].state & DRIVER_REGISTERED )
+   UG_S16 n;
+
+   if ( x2 < x1 )
    {
-      gui->driver[type].state &= ~DRIVER_ENABLED;
+      n = x2;
+      x2 = x1;
+      x1 = n;
    }
-}
-
-/* -------------------------------------------------------------------------------- */
-/* -- MISCELLANEOUS FUNCTIONS                                                    -- */
-/* -------------------------------------------------------------------------------- */
-void UG_Update( void )
-{
-   UG_WINDOW* wnd;
 
-   /* Is somebody waiting for this update? */
-   if ( gui->state & UG_SATUS_WAIT_FOR_UPDATE ) gui->state &= ~UG_SATUS_WAIT_FOR_UPDATE;
+   /* Clip the whole span */
+   if ( (y < gui->clip.a.ys) || (y > gui->clip.a.ye) ) return;
+   if ( x1 < gui->clip.a.xs ) x1 = gui->clip.a.xs;
+   if ( x2 > gui->clip.a.xe ) x2 = gui->clip.a.xe;
+   if ( x1 > x2 ) return;
 
-   /* Keep track of the windows */
-   if ( gui->next_window != gui->active_window )
+   /* Is hardware acceleration available? */
+   if ( gui->driver[DRIVER_DRAW_HLINE].state & DRIVER_ENABLED )
    {
-      if ( gui->next_window != NULL )
-      {
-         gui->last_window = gui->active_window;
-         gui->active_window = gui->next_window;
+      if( ((UG_RESULT(*)(UG_S16 x1, UG_S16 x2, UG_S16 y, UG_COLOR c))gui->driver[DRIVER_DRAW_HLINE].driver)(x1,x2,y,c) == UG_RESULT_OK ) return;
+   }
+
+   if ( gui->surface.format == SURFACE_FORMAT_NONE )
+   {
+      for( n=x1; n<=x2; n++ ) gui->pset(n,y,c);
+      return;
+   }
+
+   if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+   {
+      UG_U16* d = (UG_U16*)_UG_SURFACE_LINE(y) + x1;
+      UG_U16 v = _UG_SURFACE_RGB565(c);
+      for( n=x1; n<=x2; n++ ) *d++ = v;
+   }
+   else
+   {
+      UG_U32* d = (UG_U32*)_UG_SURFACE_LINE(y) + x1;
+      UG_U32 v = _UG_SURFACE_ARGB8888(c);
+      for( n=x1; n<=x2; n++ ) *d++ = v;
+   }
+}
+
+void _UG_VLine( UG_S16 x, UG_S16 y1, UG_S16 y2, UG_COLOR c )
+{
+   UG_S16 n;
+   UG_U8* d;
+
+   if ( y2 < y1 )
+   {
+      n = y2;
+      y2 = y1;
+      y1 = n;
+   }
+
+   /* Clip the whole span */
+   if ( (x < gui->clip.a.xs) || (x > gui->clip.a.xe) ) return;
+   if ( y1 < gui->clip.a.ys ) y1 = gui->clip.a.ys;
+   if ( y2 > gui->clip.a.ye ) y2 = gui->clip.a.ye;
+   if ( y1 > y2 ) return;
+
+   /* Is hardware acceleration available? */
+   if ( gui->driver[DRIVER_DRAW_VLINE].state & DRIVER_ENABLED )
+   {
+      if( ((UG_RESULT(*)(UG_S16 x, UG_S16 y1, UG_S16 y2, UG_COLOR c))gui->driver[DRIVER_DRAW_VLINE].driver)(x,y1,y2,c) == UG_RESULT_OK ) return;
+   }
+
+   if ( gui->surface.format == SURFACE_FORMAT_NONE )
+   {
+      for( n=y1; n<=y2; n++ ) gui->pset(x,n,c);
+      return;
+   }
+
+   d = _UG_SURFACE_LINE(y1);
+   if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+   {
+      UG_U16 v = _UG_SURFACE_RGB565(c);
+      for( n=y1; n<=y2; n++, d+=gui->surface.stride ) ((UG_U16*)d)[x] = v;
+   }
+   else
+   {
+      UG_U32 v = _UG_SURFACE_ARGB8888(c);
+      for( n=y1; n<=y2; n++, d+=gui->surface.stride ) ((UG_U32*)d)[x] = v;
+   }
+}
+
+/* 1 bpp glyph, LSB first, rows padded to whole bytes */
+void _UG_PutGlyph( unsigned char* p, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc, UG_COLOR bc )
+{
+   UG_S16 i,j,k,cw,bn;
+   UG_U8 b,direct,inside;
+#ifdef USE_GLYPH_CACHE
+   UG_U8* r;
+#endif
+
+   bn = (w + 7) >> 3;
+
+   inside = _UG_CLIP_INSIDE(x,y) && _UG_CLIP_INSIDE(x+w-1,y+h-1);
+
+   /* Is hardware acceleration available? Only for glyphs inside the clip area */
+   if ( (gui->driver[DRIVER_PUT_GLYPH].state & DRIVER_ENABLED) && inside )
+   {
+      if( ((UG_RESULT(*)(unsigned char* p, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc, UG_COLOR bc))gui->driver[DRIVER_PUT_GLYPH].driver)(p,x,y,w,h,fc,bc) == UG_RESULT_OK ) return;
+   }
+
+   /* Whole glyph on the surface: write the rows directly */
+   direct = (gui->surface.format != SURFACE_FORMAT_NONE) && inside;
+
+#ifdef USE_GLYPH_CACHE
+   if ( direct )
+   {
+      r = _UG_GlyphCacheGet(p, w, h);
+      if ( r != NULL )
+      {
+         _UG_PutGlyphRuns(r, x, y, w, h, fc, bc);
+         return;
+      }
+   }
+#endif
+
+   if ( direct )
+   {
+      if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+      {
+         UG_U16 f = _UG_SURFACE_RGB565(fc);
+         UG_U16 g = _UG_SURFACE_RGB565(bc);
+         for( j=0;j<h;j++ )
+         {
+            UG_U16* d = (UG_U16*)_UG_SURFACE_LINE(y + j) + x;
+            cw = w;
+            for( i=0;i<bn;i++ )
+            {
+               b = *p++;
+               for( k=0;(k<8) && cw;k++,cw-- )
+               {
+                  *d++ = (b & 0x01) ? f : g;
+                  b >>= 1;
+               }
+            }
+         }
+      }
+      else
+      {
+         UG_U32 f = _UG_SURFACE_ARGB8888(fc);
+         UG_U32 g = _UG_SURFACE_ARGB8888(bc);
+         for( j=0;j<h;j++ )
+         {
+            UG_U32* d = (UG_U32*)_UG_SURFACE_LINE(y + j) + x;
+            cw = w;
+            for( i=0;i<bn;i++ )
+            {
+               b = *p++;
+               for( k=0;(k<8) && cw;k++,cw-- )
+               {
+                  *d++ = (b & 0x01) ? f : g;
+                  b >>= 1;
+               }
+            }
+         }
+      }
+      return;
+   }
+
+   /* Clipped or no surface: pixel by pixel, rows outside the clip area skipped */
+   for( j=0;j<h;j++ )
+   {
+      if ( (y + j < gui->clip.a.ys) || (y + j > gui->clip.a.ye) )
+      {
+         p += bn;
+         continue;
+      }
+      cw = w;
+      for( i=0;i<bn;i++ )
+      {
+         b = *p++;
+         for( k=0;(k<8) && cw;k++,cw-- )
+         {
+            _UG_PutPixel(x + (i << 3) + k, y + j, (b & 0x01) ? fc : bc);
+            b >>= 1;
+         }
+      }
+   }
+}
+
+/* Trailing zeros of a non-zero word (RBIT + CLZ on Cortex-M) */
+#ifdef __GNUC__
+#define _UG_CTZ(v)                __builtin_ctz(v)
+#else
+static UG_S16 _UG_CTZ( UG_U32 v )
+{
+   UG_S16 n=0;
+   while ( !(v & 0x01) )
+   {
+      v >>= 1;
+      n++;
+   }
+   return n;
+}
+#endif
+
+/* 1 bpp glyph, foreground only. Cached glyphs are drawn from their runs;  */
+/* otherwise each row is taken 32 pixels at a time and the runs of set     */
+/* bits are found by bit scan and drawn as spans.                          */
+void _UG_PutGlyphTransparent( unsigned char* p, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc )
+{
+   UG_S16 i,j,k,n,xp,bn;
+   UG_U32 b;
+#ifdef USE_GLYPH_CACHE
+   UG_U8* r;
+
+   r = _UG_GlyphCacheGet(p, w, h);
+   if ( r != NULL )
+   {
+      _UG_PutGlyphRunsTransparent(r, x, y, w, h, fc);
+      return;
+   }
+#endif
+
+   bn = (w + 7) >> 3;
+   for( j=0;j<h;j++ )
+   {
+      for( i=0;i<bn;i+=4 )
+      {
+         /* First pixel in bit 0 */
+         b = 0;
+         for( k=0;(k<4) && (i+k<bn);k++ ) b |= (UG_U32)p[i+k] << (k << 3);
+         if ( w - (i << 3) < 32 ) b &= ((UG_U32)1 << (w - (i << 3))) - 1;
+
+         xp = x + (i << 3);
+         while ( b )
+         {
+            n = _UG_CTZ(b);
+            xp += n;
+            b >>= n;
+            n = ( ~b ) ? _UG_CTZ(~b) : 32;
+            _UG_HLine(xp, xp + n - 1, y + j, fc);
+            xp += n;
+            b = ( n < 32 ) ? b >> n : 0;
+         }
+      }
+      p += bn;
+   }
+}
+
+/* Glyph of "chr" in a font bitmap, NULL for an empty font */
+unsigned char* _UG_GetGlyph( unsigned char* font, UG_S16 w, UG_S16 h, char chr )
+{
+   UG_U16 bn;
+   UG_U8 bt;
+
+   bt = (UG_U8)chr;
+
+   switch ( bt )
+   {
+      case 0xF6: bt = 0x94; break; // �
+      case 0xD6: bt = 0x99; break; // ﾖ
+      case 0xFC: bt = 0x81; break; // �
+      case 0xDC: bt = 0x9A; break; // ﾜ
+      case 0xE4: bt = 0x84; break; // �
+      case 0xC4: bt = 0x8E; break; // ﾄ
+      case 0xB5: bt = 0xE6; break; // ｵ
+      case 0xB0: bt = 0xF8; break; // ｰ
+   }
+
+   bn = w;
+   if ( !bn ) return NULL;
+   bn >>= 3;
+   if ( w % 8 ) bn++;
+
+   return font + bt * h * bn;
+}
+
+#ifdef USE_GLYPH_CACHE
+/* Cached runs of a glyph, encoded on a miss into the least recently used  */
+/* entry. NULL if the glyph does not fit an entry.                         */
+UG_U8* _UG_GlyphCacheGet( unsigned char* p, UG_S16 w, UG_S16 h )
+{
+   UG_GLYPH_CACHE_ENTRY* e;
+   UG_GLYPH_CACHE_ENTRY* lru;
+   unsigned char* q;
+   UG_U16 i,n,size;
+   UG_S16 j,k,cw;
+   UG_U8 b,bg,run;
+
+   glyph_cache_clock++;
+   lru = &glyph_cache[0];
+   for( i=0;i<GLYPH_CACHE_ENTRIES;i++ )
+   {
+      e = &glyph_cache[i];
+      if ( e->p == p )
+      {
+         e->used = glyph_cache_clock;
+         return e->runs;
+      }
+      if ( e->used < lru->used ) lru = e;
+   }
+
+   if ( w > 255 ) return NULL;
+
+   e = lru;
+   e->p = NULL;
+   e->used = 0;
+   q = p;
+   size = 0;
+   n = (w + 7) >> 3;
+   for( j=0;j<h;j++ )
+   {
+      bg = 1;
+      run = 0;
+      cw = w;
+      for( i=0;i<n;i++ )
+      {
+         b = *q++;
+         for( k=0;(k<8) && cw;k++,cw-- )
+         {
+            if ( (b & 0x01) == bg )
+            {
+               if ( size >= GLYPH_CACHE_ENTRY_SIZE ) return NULL;
+               e->runs[size++] = run;
+               bg ^= 1;
+               run = 0;
+            }
+            run++;
+            b >>= 1;
+         }
+      }
+      if ( size >= GLYPH_CACHE_ENTRY_SIZE ) return NULL;
+      e->runs[size++] = run;
+   }
+
+   e->p = p;
+   e->used = glyph_cache_clock;
+   return e->runs;
+}
+
+/* Glyph from its runs; the whole glyph must be on the surface */
+void _UG_PutGlyphRuns( UG_U8* r, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc, UG_COLOR bc )
+{
+   UG_S16 j,cw,n;
+   UG_U8 fg;
+
+   if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+   {
+      UG_U16 c[2] = { _UG_SURFACE_RGB565(bc), _UG_SURFACE_RGB565(fc) };
+      for( j=0;j<h;j++ )
+      {
+         UG_U16* d = (UG_U16*)_UG_SURFACE_LINE(y + j) + x;
+         for( cw=w,fg=0;cw;fg^=1 )
+         {
+            n = *r++;
+            cw -= n;
+            while ( n-- ) *d++ = c[fg];
+         }
+      }
+   }
+   else
+   {
+      UG_U32 c[2] = { _UG_SURFACE_ARGB8888(bc), _UG_SURFACE_ARGB8888(fc) };
+      for( j=0;j<h;j++ )
+      {
+         UG_U32* d = (UG_U32*)_UG_SURFACE_LINE(y + j) + x;
+         for( cw=w,fg=0;cw;fg^=1 )
+         {
+            n = *r++;
+            cw -= n;
+            while ( n-- ) *d++ = c[fg];
+         }
+      }
+   }
+}
+
+/* Foreground runs only, as spans. Clipped like any span, so the glyph may */
+/* be partly visible and no surface is needed.                             */
+void _UG_PutGlyphRunsTransparent( UG_U8* r, UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, UG_COLOR fc )
+{
+   UG_S16 j,cw,n,xp;
+   UG_U8 fg;
+
+   for( j=0;j<h;j++ )
+   {
+      xp = x;
+      for( cw=w,fg=0;cw;fg^=1 )
+      {
+         n = *r++;
+         cw -= n;
+         if ( fg ) _UG_HLine(xp, xp + n - 1, y + j, fc);
+         xp += n;
+      }
+   }
+}
+#endif
+
+void UG_GlyphCacheClear( void )
+{
+#ifdef USE_GLYPH_CACHE
+   UG_U16 i;
+
+   for( i=0;i<GLYPH_CACHE_ENTRIES;i++ )
+   {
+      glyph_cache[i].p = NULL;
+      glyph_cache[i].used = 0;
+   }
+#endif
+}
+
+/* -------------------------------------------------------------------------------- */
+/* -- DRIVER FUNCTIONS                                                           -- */
+/* -------------------------------------------------------------------------------- */
+void UG_DriverRegister( UG_U8 type, void* driver )
+{
+   if ( type >= NUMBER_OF_DRIVERS ) return;
+
+   gui->driver[type].driver = driver;
+   gui->driver[type].state = DRIVER_REGISTERED | DRIVER_ENABLED;
+}
+
+void UG_DriverEnable( UG_U8 type )
+{
+   if ( type >= NUMBER_OF_DRIVERS ) return;
+   if ( gui->driver[type].state & DRIVER_REGISTERED )
+   {
+      gui->driver[type].state |= DRIVER_ENABLED;
+   }
+}
+
+void UG_DriverDisable( UG_U8 type )
+{
+   if ( type >= NUMBER_OF_DRIVERS ) return;
+   if ( gui->driver[type].state & DRIVER_REGISTERED )
+   {
+      gui->driver[type].state &= ~DRIVER_ENABLED;
+   }
+}
+
+/* -------------------------------------------------------------------------------- */
+/* -- SURFACE FUNCTIONS                                                          -- */
+/* -------------------------------------------------------------------------------- */
+/* "p" is the address of pixel (0,0), "stride" the bytes per line */
+void UG_SurfaceRegister( void* p, UG_S32 stride, UG_U8 format )
+{
+   if ( p == NULL ) format = SURFACE_FORMAT_NONE;
+   gui->surface.p = p;
+   gui->surface.stride = stride;
+   gui->surface.format = format;
+}
+
+/* -------------------------------------------------------------------------------- */
+/* -- CLIP FUNCTIONS                                                             -- */
+/* -------------------------------------------------------------------------------- */
+/* Restrict drawing to the given area, within the current clip area. */
+/* Every push needs a UG_ClipPop().                                  */
+UG_RESULT UG_ClipPush( UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S16 ye )
+{
+   UG_S16 n;
+
+   if ( gui->clip.depth >= CLIP_STACK_DEPTH ) return UG_RESULT_FAIL;
+
+   if ( xe < xs )
+   {
+      n = xe;
+      xe = xs;
+      xs = n;
+   }
+   if ( ye < ys )
+   {
+      n = ye;
+      ye = ys;
+      ys = n;
+   }
+
+   gui->clip.stack[gui->clip.depth++] = gui->clip.a;
+   if ( xs > gui->clip.a.xs ) gui->clip.a.xs = xs;
+   if ( ys > gui->clip.a.ys ) gui->clip.a.ys = ys;
+   if ( xe < gui->clip.a.xe ) gui->clip.a.xe = xe;
+   if ( ye < gui->clip.a.ye ) gui->clip.a.ye = ye;
+
+   return UG_RESULT_OK;
+}
+
+void UG_ClipPop( void )
+{
+   if ( gui->clip.depth ) gui->clip.a = gui->clip.stack[--gui->clip.depth];
+}
+
+/* -------------------------------------------------------------------------------- */
+/* -- DIRTY REGION FUNCTIONS                                                     -- */
+/* -------------------------------------------------------------------------------- */
+/* Mark an area to be redrawn by the next UG_Update(). Only the part inside */
+/* the active window is redrawn: its background and the objects it touches. */
+void UG_Invalidate( UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S16 ye )
+{
+   UG_AREA r;
+   UG_U8 i,best;
+   UG_S32 cost,best_cost;
+
+   if ( xe < xs )
+   {
+      r.xs = xe;
+      xe = xs;
+      xs = r.xs;
+   }
+   if ( ye < ys )
+   {
+      r.ys = ye;
+      ye = ys;
+      ys = r.ys;
+   }
+   if ( xs < 0 ) xs = 0;
+   if ( ys < 0 ) ys = 0;
+   if ( xe >= gui->x_dim ) xe = gui->x_dim - 1;
+   if ( ye >= gui->y_dim ) ye = gui->y_dim - 1;
+   if ( (xs > xe) || (ys > ye) ) return;
+
+   r.xs = xs;
+   r.ys = ys;
+   r.xe = xe;
+   r.ye = ye;
+
+   /* Absorb every rectangle worth merging; the grown one may reach others */
+   i = 0;
+   while ( i < gui->dirty.count )
+   {
+      if ( _UG_AreaMergeCost(&gui->dirty.rect[i], &r) <= 0 )
+      {
+         if ( gui->dirty.rect[i].xs < r.xs ) r.xs = gui->dirty.rect[i].xs;
+         if ( gui->dirty.rect[i].ys < r.ys ) r.ys = gui->dirty.rect[i].ys;
+         if ( gui->dirty.rect[i].xe > r.xe ) r.xe = gui->dirty.rect[i].xe;
+         if ( gui->dirty.rect[i].ye > r.ye ) r.ye = gui->dirty.rect[i].ye;
+         gui->dirty.rect[i] = gui->dirty.rect[--gui->dirty.count];
+         i = 0;
+      }
+      else i++;
+   }
+
+   if ( gui->dirty.count < DIRTY_MAX_RECTS )
+   {
+      gui->dirty.rect[gui->dirty.count++] = r;
+      return;
+   }
+
+   /* No room: merge with the cheapest one */
+   best = 0;
+   best_cost = _UG_AreaMergeCost(&gui->dirty.rect[0], &r);
+   for( i=1;i<gui->dirty.count;i++ )
+   {
+      cost = _UG_AreaMergeCost(&gui->dirty.rect[i], &r);
+      if ( cost < best_cost )
+      {
+         best = i;
+         best_cost = cost;
+      }
+   }
+   if ( r.xs < gui->dirty.rect[best].xs ) gui->dirty.rect[best].xs = r.xs;
+   if ( r.ys < gui->dirty.rect[best].ys ) gui->dirty.rect[best].ys = r.ys;
+   if ( r.xe > gui->dirty.rect[best].xe ) gui->dirty.rect[best].xe = r.xe;
+   if ( r.ye > gui->dirty.rect[best].ye ) gui->dirty.rect[best].ye = r.ye;
+}
+
+/* Pixels more to draw for the bounding box than for "a" and "b" apart */
+UG_S32 _UG_AreaMergeCost( UG_AREA* a, UG_AREA* b )
+{
+   UG_AREA u;
+
+   u.xs = (a->xs < b->xs) ? a->xs : b->xs;
+   u.ys = (a->ys < b->ys) ? a->ys : b->ys;
+   u.xe = (a->xe > b->xe) ? a->xe : b->xe;
+   u.ye = (a->ye > b->ye) ? a->ye : b->ye;
+
+   return (UG_S32)(u.xe - u.xs + 1) * (u.ye - u.ys + 1)
+        - (UG_S32)(a->xe - a->xs + 1) * (a->ye - a->ys + 1)
+        - (UG_S32)(b->xe - b->xs + 1) * (b->ye - b->ys + 1)
+        - DIRTY_RECT_COST;
+}
+
+UG_U8 _UG_AreaIntersect( UG_AREA* a, UG_AREA* b, UG_AREA* r )
+{
+   r->xs = (a->xs > b->xs) ? a->xs : b->xs;
+   r->ys = (a->ys > b->ys) ? a->ys : b->ys;
+   r->xe = (a->xe < b->xe) ? a->xe : b->xe;
+   r->ye = (a->ye < b->ye) ? a->ye : b->ye;
+
+   return (r->xs <= r->xe) && (r->ys <= r->ye);
+}
+
+/* Fill "r" except where it overlaps "a" */
+void _UG_FillOutside( UG_AREA* r, UG_AREA* a, UG_COLOR c )
+{
+   UG_AREA i;
+
+   if ( !_UG_AreaIntersect(r, a, &i) )
+   {
+      UG_FillFrame(r->xs, r->ys, r->xe, r->ye, c);
+      return;
+   }
+   if ( i.ys > r->ys ) UG_FillFrame(r->xs, r->ys, r->xe, i.ys-1, c);
+   if ( i.ye < r->ye ) UG_FillFrame(r->xs, i.ye+1, r->xe, r->ye, c);
+   if ( i.xs > r->xs ) UG_FillFrame(r->xs, i.ys, i.xs-1, i.ye, c);
+   if ( i.xe < r->xe ) UG_FillFrame(i.xe+1, i.ys, r->xe, i.ye, c);
+}
+
+/* Redraw the dirty part of the window, each rectangle clipped on its own: */
+/* background where no opaque object covers it, then the objects it       */
+/* touches. Objects with changes of their own are drawn in full later.    */
+void _UG_WindowRenderDirty( UG_WINDOW* wnd )
+{
+   UG_AREA w,a,r,c,o,t;
+   UG_U16 i,n,objcnt;
+   UG_OBJECT* obj;
+   UG_U8 covered;
+
+   if ( !gui->dirty.count ) return;
+
+   w.xs = wnd->xs;
+   w.ys = wnd->ys;
+   w.xe = wnd->xe;
+   w.ye = wnd->ye;
+   UG_WindowGetArea(wnd,&a);
+
+   objcnt = wnd->objcnt;
+   for( n=0;n<gui->dirty.count;n++ )
+   {
+      if ( !_UG_AreaIntersect(&gui->dirty.rect[n], &w, &r) ) continue;
+
+      /* Frame or title bar hit? */
+      if ( (r.xs < a.xs) || (r.ys < a.ys) || (r.xe > a.xe) || (r.ye > a.ye) )
+      {
+         if ( UG_ClipPush(r.xs,r.ys,r.xe,r.ye) == UG_RESULT_OK )
+         {
+            if ( wnd->style & WND_STYLE_3D ) _UG_DrawObjectFrame(w.xs,w.ys,w.xe,w.ye,(UG_COLOR*)pal_window);
+            if ( wnd->style & WND_STYLE_SHOW_TITLE ) _UG_WindowDrawTitle( wnd );
+            UG_ClipPop();
+         }
+      }
+      if ( !_UG_AreaIntersect(&r, &a, &c) ) continue;
+      if ( UG_ClipPush(c.xs,c.ys,c.xe,c.ye) != UG_RESULT_OK ) continue;
+
+      /* Buttons and textboxes fill their whole area */
+      covered = 0;
+      for( i=0;i<objcnt;i++ )
+      {
+         obj = (UG_OBJECT*)&wnd->objlst[i];
+         if ( (obj->state & OBJ_STATE_FREE) || !(obj->state & OBJ_STATE_VALID) || !(obj->state & OBJ_STATE_VISIBLE) ) continue;
+         if ( (obj->type != OBJ_TYPE_BUTTON) && (obj->type != OBJ_TYPE_TEXTBOX) ) continue;
+         o.xs = obj->a_rel.xs + a.xs;
+         o.ys = obj->a_rel.ys + a.ys;
+         o.xe = obj->a_rel.xe + a.xs;
+         o.ye = obj->a_rel.ye + a.ys;
+         if ( (o.xs <= c.xs) && (o.ys <= c.ys) && (o.xe >= c.xe) && (o.ye >= c.ye) ) covered = 1;
+      }
+      if ( !covered ) UG_FillFrame(c.xs, c.ys, c.xe, c.ye, wnd->bc);
+
+      for( i=0;i<objcnt;i++ )
+      {
+         obj = (UG_OBJECT*)&wnd->objlst[i];
+         if ( (obj->state & OBJ_STATE_FREE) || !(obj->state & OBJ_STATE_VALID) || !(obj->state & OBJ_STATE_VISIBLE) ) continue;
+
+         o.xs = obj->a_rel.xs + a.xs;
+         o.ys = obj->a_rel.ys + a.ys;
+         o.xe = obj->a_rel.xe + a.xs;
+         o.ye = obj->a_rel.ye + a.ys;
+         if ( !_UG_AreaIntersect(&c, &o, &t) ) continue;
+
+         /* Changes of its own pending? Then it is drawn in full by _UG_UpdateObjects */
+         if ( (obj->state & OBJ_STATE_UPDATE) || (obj->touch_state & OBJ_TOUCH_STATE_CHANGED) )
+         {
+            obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
+            continue;
+         }
+         obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
+         obj->update(wnd,obj);
+      }
+      UG_ClipPop();
+   }
+   gui->dirty.count = 0;
+}
+
+/* -------------------------------------------------------------------------------- */
+/* -- MISCELLANEOUS FUNCTIONS                                                    -- */
+/* -------------------------------------------------------------------------------- */
+void UG_Update( void )
+{
+   UG_WINDOW* wnd;
+
+   /* Is somebody waiting for this update? */
+   if ( gui->state & UG_SATUS_WAIT_FOR_UPDATE ) gui->state &= ~UG_SATUS_WAIT_FOR_UPDATE;
+
+   /* Keep track of the windows */
+   if ( gui->next_window != gui->active_window )
+   {
+      if ( gui->next_window != NULL )
+      {
+         gui->last_window = gui->active_window;
+         gui->active_window = gui->next_window;
 
          /* Do we need to draw an inactive title? */
          if ( (gui->last_window->style & WND_STYLE_SHOW_TITLE) && (gui->last_window->state & WND_STATE_VISIBLE) )
@@ -5297,6 +6225,7 @@ void UG_Update( void )
       /* Is the window visible? */
       if ( wnd->state & WND_STATE_VISIBLE )
       {
+         _UG_WindowRenderDirty( wnd );
          _UG_ProcessTouchData( wnd );
          _UG_UpdateObjects( wnd );
          _UG_HandleEvents( wnd );
@@ -5310,44 +6239,250 @@ void UG_WaitForUpdate( void )
    while ( (volatile UG_U8)gui->state & UG_SATUS_WAIT_FOR_UPDATE ){};
 }
 
-void UG_DrawBMP( UG_S16 xp, UG_S16 yp, UG_BMP* bmp )
+/* Pixel formats of UG_DrawBMP, from bpp and colors */
+#define _UG_BMP_UNSUPPORTED       0
+#define _UG_BMP_MONO              1
+#define _UG_BMP_RGB332            2
+#define _UG_BMP_RGB555            3
+#define _UG_BMP_RGB565            4
+#define _UG_BMP_XRGB8888          5
+
+UG_U8 _UG_BMPFormat( UG_BMP* bmp )
 {
-   UG_S16 x,y,xs;
-   UG_U8 r,g,b;
-   UG_U16* p;
-   UG_U16 tmp;
-   UG_COLOR c;
+   switch ( bmp->bpp )
+   {
+      case BMP_BPP_1:
+         return _UG_BMP_MONO;
+      case BMP_BPP_8:
+         if ( bmp->colors == BMP_RGB332 ) return _UG_BMP_RGB332;
+         break;
+      case BMP_BPP_16:
+         if ( bmp->colors == BMP_RGB565 ) return _UG_BMP_RGB565;
+         if ( bmp->colors == BMP_RGB555 ) return _UG_BMP_RGB555;
+         break;
+      case BMP_BPP_32:
+         if ( bmp->colors == BMP_RGB888 ) return _UG_BMP_XRGB8888;
+         break;
+   }
+   return _UG_BMP_UNSUPPORTED;
+}
 
-   if ( bmp->p == NULL ) return;
+/* Bytes per bitmap row */
+UG_S32 _UG_BMPStride( UG_BMP* bmp, UG_U8 fmt )
+{
+   switch ( fmt )
+   {
+      case _UG_BMP_MONO:     return ((UG_S32)bmp->width + 7) >> 3;
+      case _UG_BMP_RGB332:   return (UG_S32)bmp->width;
+      case _UG_BMP_XRGB8888: return (UG_S32)bmp->width << 2;
+      default:               return (UG_S32)bmp->width << 1;
+   }
+}
 
-   /* Only support 16 BPP so far */
-   if ( bmp->bpp == BMP_BPP_16 )
+/* Pixel x of bitmap row s as UG_COLOR */
+UG_COLOR _UG_BMPGetPixel( const UG_U8* s, UG_U8 fmt, UG_S16 x )
+{
+   UG_U32 v;
+
+   switch ( fmt )
    {
-      p = (UG_U16*)bmp->p;
+      case _UG_BMP_MONO:
+         return ( s[x >> 3] & (1 << (x & 7)) ) ? gui->fore_color : gui->back_color;
+      case _UG_BMP_RGB332:
+         v = s[x];
+         return UG_RGB( ((v & 0xE0) << 16) | ((v & 0x1C) << 11) | ((v & 0x03) << 6) );
+      case _UG_BMP_RGB555:
+         v = ((UG_U16*)s)[x];
+         return UG_RGB( ((v & 0x7C00) << 9) | ((v & 0x03E0) << 6) | ((v & 0x001F) << 3) );
+      case _UG_BMP_RGB565:
+         v = ((UG_U16*)s)[x];
+#if UG_COLOR_FORMAT == UG_COLOR_RGB565
+         return (UG_COLOR)v;
+#else
+         return UG_RGB( ((v & 0xF800) << 8) | ((v & 0x07E0) << 5) | ((v & 0x001F) << 3) );
+#endif
+      default:
+         v = ((UG_U32*)s)[x];
+         return UG_RGB( v & 0xFFFFFF );
    }
-   else
+}
+
+/* Pixels x..x+n-1 of bitmap row s to an RGB565 surface line */
+void _UG_BlitRow565( UG_U16* d, const UG_U8* s, UG_U8 fmt, UG_S16 x, UG_S16 n )
+{
+   const UG_U32* p;
+   const UG_U16* q;
+   UG_U32 v0,v1,v2,v3;
+   UG_U16 c[2];
+
+   switch ( fmt )
    {
-      return;
+      case _UG_BMP_RGB565:
+         memcpy(d, (const UG_U16*)s + x, (size_t)n << 1);
+         return;
+      case _UG_BMP_XRGB8888:
+         /* Four pixels per pass: independent loads and stores the compiler can schedule or vectorise */
+         p = (const UG_U32*)s + x;
+         for( ;n>=4;n-=4,p+=4,d+=4 )
+         {
+            v0 = p[0]; v1 = p[1]; v2 = p[2]; v3 = p[3];
+            d[0] = (UG_U16)(((v0 >> 8) & 0xF800) | ((v0 >> 5) & 0x07E0) | ((v0 >> 3) & 0x001F));
+            d[1] = (UG_U16)(((v1 >> 8) & 0xF800) | ((v1 >> 5) & 0x07E0) | ((v1 >> 3) & 0x001F));
+            d[2] = (UG_U16)(((v2 >> 8) & 0xF800) | ((v2 >> 5) & 0x07E0) | ((v2 >> 3) & 0x001F));
+            d[3] = (UG_U16)(((v3 >> 8) & 0xF800) | ((v3 >> 5) & 0x07E0) | ((v3 >> 3) & 0x001F));
+         }
+         for( ;n>0;n--,p++ )
+         {
+            v0 = *p;
+            *d++ = (UG_U16)(((v0 >> 8) & 0xF800) | ((v0 >> 5) & 0x07E0) | ((v0 >> 3) & 0x001F));
+         }
+         return;
+      case _UG_BMP_RGB555:
+         /* Red and green move up one bit; green gets a zero low bit */
+         q = (const UG_U16*)s + x;
+         for( ;n>=4;n-=4,q+=4,d+=4 )
+         {
+            v0 = q[0]; v1 = q[1]; v2 = q[2]; v3 = q[3];
+            d[0] = (UG_U16)(((v0 & 0x7FE0) << 1) | (v0 & 0x001F));
+            d[1] = (UG_U16)(((v1 & 0x7FE0) << 1) | (v1 & 0x001F));
+            d[2] = (UG_U16)(((v2 & 0x7FE0) << 1) | (v2 & 0x001F));
+            d[3] = (UG_U16)(((v3 & 0x7FE0) << 1) | (v3 & 0x001F));
+         }
+         for( ;n>0;n--,q++ )
+         {
+            v0 = *q;
+            *d++ = (UG_U16)(((v0 & 0x7FE0) << 1) | (v0 & 0x001F));
+         }
+         return;
+      case _UG_BMP_RGB332:
+         /* Each channel to the top of its RGB565 field */
+         s += x;
+         for( ;n>0;n-- )
+         {
+            v0 = *s++;
+            *d++ = (UG_U16)(((v0 & 0xE0) << 8) | ((v0 & 0x1C) << 6) | ((v0 & 0x03) << 3));
+         }
+         return;
+      case _UG_BMP_MONO:
+         c[0] = _UG_SURFACE_RGB565(gui->back_color);
+         c[1] = _UG_SURFACE_RGB565(gui->fore_color);
+         for( ;n>0;n--,x++ ) *d++ = c[(s[x >> 3] >> (x & 7)) & 1];
+         return;
    }
+}
 
-   xs = xp;
-   for(y=0;y<bmp->height;y++)
+/* Pixels x..x+n-1 of bitmap row s to an ARGB8888 surface line */
+void _UG_BlitRow8888( UG_U32* d, const UG_U8* s, UG_U8 fmt, UG_S16 x, UG_S16 n )
+{
+   const UG_U16* p;
+   const UG_U32* q;
+   UG_U32 v0,v1,v2,v3;
+   UG_U32 c[2];
+
+   switch ( fmt )
+   {
+      case _UG_BMP_XRGB8888:
+         /* The top byte of a BMP_RGB888 pixel is undefined: force it opaque as the other formats do */
+         q = (const UG_U32*)s + x;
+         for( ;n>=4;n-=4,q+=4,d+=4 )
+         {
+            d[0] = 0xFF000000 | q[0];
+            d[1] = 0xFF000000 | q[1];
+            d[2] = 0xFF000000 | q[2];
+            d[3] = 0xFF000000 | q[3];
+         }
+         for( ;n>0;n-- )
+            *d++ = 0xFF000000 | *q++;
+         return;
+      case _UG_BMP_RGB565:
+         p = (const UG_U16*)s + x;
+         for( ;n>=4;n-=4,p+=4,d+=4 )
+         {
+            v0 = p[0]; v1 = p[1]; v2 = p[2]; v3 = p[3];
+            d[0] = 0xFF000000 | ((v0 & 0xF800) << 8) | ((v0 & 0x07E0) << 5) | ((v0 & 0x001F) << 3);
+            d[1] = 0xFF000000 | ((v1 & 0xF800) << 8) | ((v1 & 0x07E0) << 5) | ((v1 & 0x001F) << 3);
+            d[2] = 0xFF000000 | ((v2 & 0xF800) << 8) | ((v2 & 0x07E0) << 5) | ((v2 & 0x001F) << 3);
+            d[3] = 0xFF000000 | ((v3 & 0xF800) << 8) | ((v3 & 0x07E0) << 5) | ((v3 & 0x001F) << 3);
+         }
+         for( ;n>0;n--,p++ )
+         {
+            v0 = *p;
+            *d++ = 0xFF000000 | ((v0 & 0xF800) << 8) | ((v0 & 0x07E0) << 5) | ((v0 & 0x001F) << 3);
+         }
+         return;
+      case _UG_BMP_RGB555:
+         p = (const UG_U16*)s + x;
+         for( ;n>=4;n-=4,p+=4,d+=4 )
+         {
+            v0 = p[0]; v1 = p[1]; v2 = p[2]; v3 = p[3];
+            d[0] = 0xFF000000 | ((v0 & 0x7C00) << 9) | ((v0 & 0x03E0) << 6) | ((v0 & 0x001F) << 3);
+            d[1] = 0xFF000000 | ((v1 & 0x7C00) << 9) | ((v1 & 0x03E0) << 6) | ((v1 & 0x001F) << 3);
+            d[2] = 0xFF000000 | ((v2 & 0x7C00) << 9) | ((v2 & 0x03E0) << 6) | ((v2 & 0x001F) << 3);
+            d[3] = 0xFF000000 | ((v3 & 0x7C00) << 9) | ((v3 & 0x03E0) << 6) | ((v3 & 0x001F) << 3);
+         }
+         for( ;n>0;n--,p++ )
+         {
+            v0 = *p;
+            *d++ = 0xFF000000 | ((v0 & 0x7C00) << 9) | ((v0 & 0x03E0) << 6) | ((v0 & 0x001F) << 3);
+         }
+         return;
+      case _UG_BMP_RGB332:
+         s += x;
+         for( ;n>0;n-- )
+         {
+            v0 = *s++;
+            *d++ = 0xFF000000 | ((v0 & 0xE0) << 16) | ((v0 & 0x1C) << 11) | ((v0 & 0x03) << 6);
+         }
+         return;
+      case _UG_BMP_MONO:
+         c[0] = _UG_SURFACE_ARGB8888(gui->back_color);
+         c[1] = _UG_SURFACE_ARGB8888(gui->fore_color);
+         for( ;n>0;n--,x++ ) *d++ = c[(s[x >> 3] >> (x & 7)) & 1];
+         return;
+   }
+}
+
+void UG_DrawBMP( UG_S16 xp, UG_S16 yp, UG_BMP* bmp )
+{
+   UG_S16 x,y,x0,x1,y0,y1;
+   UG_S32 stride;
+   UG_U8 fmt;
+   const UG_U8* s;
+
+   if ( bmp->p == NULL ) return;
+
+   /* Is hardware acceleration available? Only for bitmaps inside the clip area */
+   if ( (gui->driver[DRIVER_DRAW_BMP].state & DRIVER_ENABLED) && _UG_CLIP_INSIDE(xp,yp) && _UG_CLIP_INSIDE(xp+bmp->width-1,yp+bmp->height-1) )
+   {
+      if( ((UG_RESULT(*)(UG_S16 xp, UG_S16 yp, UG_BMP* bmp))gui->driver[DRIVER_DRAW_BMP].driver)(xp,yp,bmp) == UG_RESULT_OK ) return;
+   }
+
+   fmt = _UG_BMPFormat(bmp);
+   if ( fmt == _UG_BMP_UNSUPPORTED ) return;
+   stride = _UG_BMPStride(bmp, fmt);
+
+   /* Visible part, in bitmap coordinates */
+   x0 = ( xp < gui->clip.a.xs ) ? gui->clip.a.xs - xp : 0;
+   y0 = ( yp < gui->clip.a.ys ) ? gui->clip.a.ys - yp : 0;
+   x1 = ( (UG_S32)xp + bmp->width - 1 > gui->clip.a.xe ) ? gui->clip.a.xe - xp : bmp->width - 1;
+   y1 = ( (UG_S32)yp + bmp->height - 1 > gui->clip.a.ye ) ? gui->clip.a.ye - yp : bmp->height - 1;
+   if ( (x0 > x1) || (y0 > y1) ) return;
+
+   s = (const UG_U8*)bmp->p + y0 * stride;
+   for( y=y0;y<=y1;y++,s+=stride )
    {
-      xp = xs;
-      for(x=0;x<bmp->width;x++)
+      if ( gui->surface.format == SURFACE_FORMAT_RGB565 )
+      {
+         _UG_BlitRow565((UG_U16*)_UG_SURFACE_LINE(yp + y) + xp + x0, s, fmt, x0, x1 - x0 + 1);
+      }
+      else if ( gui->surface.format == SURFACE_FORMAT_ARGB8888 )
+      {
+         _UG_BlitRow8888((UG_U32*)_UG_SURFACE_LINE(yp + y) + xp + x0, s, fmt, x0, x1 - x0 + 1);
+      }
+      else
       {
-         tmp = *p++;
-         /* Convert RGB565 to RGB888 */
-         r = (tmp>>11)&0x1F;
-         r<<=3;
-         g = (tmp>>5)&0x3F;
-         g<<=2;
-         b = (tmp)&0x1F;
-         b<<=3;
-         c = ((UG_COLOR)r<<16) | ((UG_COLOR)g<<8) | (UG_COLOR)b;
-         UG_DrawPixel( xp++ , yp , c );
+         for( x=x0;x<=x1;x++ ) gui->pset(xp + x, yp + y, _UG_BMPGetPixel(s, fmt, x));
       }
-      yp++;
    }
 }
 
@@ -5380,8 +6515,8 @@ UG_RESULT UG_WindowCreate( UG_WINDOW* wnd, UG_OBJECT* objlst, UG_U8 objcnt, void
    wnd->objcnt = objcnt;
    wnd->objlst = objlst;
    wnd->state = WND_STATE_VALID;
-   wnd->fc = 0x000000;
-   wnd->bc = 0xF0F0F0;
+   wnd->fc = UG_RGB(0x000000);
+   wnd->bc = UG_RGB(0xF0F0F0);
    wnd->xs = 0;
    wnd->ys = 0;
    wnd->xe = UG_GetXDim()-1;
@@ -5400,6 +6535,7 @@ UG_RESULT UG_WindowCreate( UG_WINDOW* wnd, UG_OBJECT* objlst, UG_U8 objcnt, void
    wnd->title.ifc = C_WHITE;
    wnd->title.ibc = C_GRAY;
    wnd->title.height = 15;
+   wnd->title.layout.valid = 0;
 
    return UG_RESULT_OK;
 }
@@ -5473,6 +6609,7 @@ UG_RESULT UG_WindowResize( UG_WINDOW* wnd, UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S
 {
    UG_S16 pos;
    UG_S16 xmax,ymax;
+   UG_AREA o,n;
 
    xmax = UG_GetXDim()-1;
    ymax = UG_GetYDim()-1;
@@ -5488,6 +6625,10 @@ UG_RESULT UG_WindowResize( UG_WINDOW* wnd, UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S
       if ( pos < 10 ) return UG_RESULT_FAIL;
 
       /* ... and if everything is OK move the window! */
+      o.xs = wnd->xs;
+      o.ys = wnd->ys;
+      o.xe = wnd->xe;
+      o.ye = wnd->ye;
       wnd->xs = xs;
       wnd->ys = ys;
       wnd->xe = xe;
@@ -5495,12 +6636,12 @@ UG_RESULT UG_WindowResize( UG_WINDOW* wnd, UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S
 
       if ( (wnd->state & WND_STATE_VISIBLE) && (gui->active_window == wnd) )
       {
-         if ( wnd->ys ) UG_FillFrame(0, 0, xmax,wnd->ys-1,gui->desktop_color);
-         pos = wnd->ye+1;
-         if ( !(pos > ymax) ) UG_FillFrame(0, pos, xmax,ymax,gui->desktop_color);
-         if ( wnd->xs ) UG_FillFrame(0, wnd->ys, wnd->xs-1,wnd->ye,gui->desktop_color);
-         pos = wnd->xe+1;
-         if ( !(pos > xmax) ) UG_FillFrame(pos, wnd->ys,xmax,wnd->ye,gui->desktop_color);
+         /* Only the area the window left becomes desktop */
+         n.xs = xs;
+         n.ys = ys;
+         n.xe = xe;
+         n.ye = ye;
+         _UG_FillOutside(&o, &n, gui->desktop_color);
 
          wnd->state &= ~WND_STATE_REDRAW_TITLE;
          wnd->state |= WND_STATE_UPDATE;
@@ -5590,6 +6731,7 @@ UG_RESULT UG_WindowSetTitleText( UG_WINDOW* wnd, char* str )
    if ( (wnd != NULL) && (wnd->state & WND_STATE_VALID) )
    {
       wnd->title.str = str;
+      wnd->title.layout.valid = 0;
       wnd->state |= WND_STATE_UPDATE | WND_STATE_REDRAW_TITLE;
       return UG_RESULT_OK;
    }
@@ -5602,6 +6744,7 @@ UG_RESULT UG_WindowSetTitleTextFont( UG_WINDOW* wnd, const UG_FONT* font )
    {
       wnd->state |= WND_STATE_UPDATE | WND_STATE_REDRAW_TITLE;
       wnd->title.font = font;
+      wnd->title.layout.valid = 0;
       if ( wnd->title.height <= (font->char_height + 1) )
       {
          wnd->title.height = font->char_height + 2;
@@ -5617,6 +6760,7 @@ UG_RESULT UG_WindowSetTitleTextHSpace( UG_WINDOW* wnd, UG_S8 hs )
    if ( (wnd != NULL) && (wnd->state & WND_STATE_VALID) )
    {
       wnd->title.h_space = hs;
+      wnd->title.layout.valid = 0;
       wnd->state |= WND_STATE_UPDATE | WND_STATE_REDRAW_TITLE;
       return UG_RESULT_OK;
    }
@@ -5628,6 +6772,7 @@ UG_RESULT UG_WindowSetTitleTextVSpace( UG_WINDOW* wnd, UG_S8 vs )
    if ( (wnd != NULL) && (wnd->state & WND_STATE_VALID) )
    {
       wnd->title.v_space = vs;
+      wnd->title.layout.valid = 0;
       wnd->state |= WND_STATE_UPDATE | WND_STATE_REDRAW_TITLE;
       return UG_RESULT_OK;
    }
@@ -5639,6 +6784,7 @@ UG_RESULT UG_WindowSetTitleTextAlignment( UG_WINDOW* wnd, UG_U8 align )
    if ( (wnd != NULL) && (wnd->state & WND_STATE_VALID) )
    {
       wnd->title.align = align;
+      wnd->title.layout.valid = 0;
       wnd->state |= WND_STATE_UPDATE | WND_STATE_REDRAW_TITLE;
       return UG_RESULT_OK;
    }
@@ -6026,6 +7172,8 @@ UG_RESULT _UG_WindowDrawTitle( UG_WINDOW* wnd )
       txt.align = wnd->title.align;
       txt.h_space = wnd->title.h_space;
       txt.v_space = wnd->title.v_space;
+      txt.transparent = 1;
+      txt.layout = &wnd->title.layout;
       _UG_PutText( &txt );
 
       /* Draw line */
@@ -6037,8 +7185,6 @@ UG_RESULT _UG_WindowDrawTitle( UG_WINDOW* wnd )
 
 void _UG_WindowUpdate( UG_WINDOW* wnd )
 {
-   UG_U16 i,objcnt;
-   UG_OBJECT* obj;
    UG_S16 xs,ys,xe,ye;
 
    xs = wnd->xs;
@@ -6070,40 +7216,42 @@ void _UG_WindowUpdate( UG_WINDOW* wnd )
             return;
          }
       }
-      /* Draw window area? */
-      UG_FillFrame(xs,ys,xe,ye,wnd->bc);
-
-      /* Force each object to be updated! */
-      objcnt = wnd->objcnt;
-      for(i=0; i<objcnt; i++)
-      {
-         obj = (UG_OBJECT*)&wnd->objlst[i];
-         if ( !(obj->state & OBJ_STATE_FREE) && (obj->state & OBJ_STATE_VALID) && (obj->state & OBJ_STATE_VISIBLE) ) obj->state |= (OBJ_STATE_UPDATE | OBJ_STATE_REDRAW);
-      }
+      /* Window area and objects are drawn as a dirty region */
+      UG_Invalidate(xs,ys,xe,ye);
    }
    else
    {
-      UG_FillFrame(wnd->xs,wnd->xs,wnd->xe,wnd->ye,gui->desktop_color);
+      UG_FillFrame(wnd->xs,wnd->ys,wnd->xe,wnd->ye,gui->desktop_color);
    }
 }
 
 UG_RESULT _UG_WindowClear( UG_WINDOW* wnd )
 {
+   UG_AREA r,a;
+
    if ( wnd != NULL )
    {
       if (wnd->state & WND_STATE_VISIBLE)
       {
          wnd->state &= ~WND_STATE_VISIBLE;
-         UG_FillFrame( wnd->xs, wnd->ys, wnd->xe, wnd->ye, gui->desktop_color );
+         r.xs = wnd->xs;
+         r.ys = wnd->ys;
+         r.xe = wnd->xe;
+         r.ye = wnd->ye;
 
-         if ( wnd != gui->active_window )
+         /* If the current window is visible, it redraws the part it covers */
+         if ( (wnd != gui->active_window) && (gui->active_window != NULL) && (gui->active_window->state & WND_STATE_VISIBLE) )
          {
-            /* If the current window is visible, update it! */
-            if ( gui->active_window->state & WND_STATE_VISIBLE )
-            {
-               gui->active_window->state &= ~WND_STATE_REDRAW_TITLE;
-               gui->active_window->state |= WND_STATE_UPDATE;
-            }
+            a.xs = gui->active_window->xs;
+            a.ys = gui->active_window->ys;
+            a.xe = gui->active_window->xe;
+            a.ye = gui->active_window->ye;
+            _UG_FillOutside( &r, &a, gui->desktop_color );
+            UG_Invalidate( r.xs, r.ys, r.xe, r.ye );
+         }
+         else
+         {
+            UG_FillFrame( r.xs, r.ys, r.xe, r.ye, gui->desktop_color );
          }
       }
       return UG_RESULT_OK;
@@ -6130,6 +7278,7 @@ UG_RESULT UG_ButtonCreate( UG_WINDOW* wnd, UG_BUTTON* btn, UG_U8 id, UG_S16 xs,
    btn->style = BTN_STYLE_3D;
    btn->font = NULL;
    btn->str = "-";
+   btn->layout.valid = 0;
 
    /* Initialize standard object parameters */
    obj->update = _UG_ButtonUpdate;
@@ -6261,6 +7410,7 @@ UG_RESULT UG_ButtonSetText( UG_WINDOW* wnd, UG_U8 id, char* str )
 
    btn = (UG_BUTTON*)(obj->data);
    btn->str = str;
+   btn->layout.valid = 0;
    obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
 
    return UG_RESULT_OK;
@@ -6276,6 +7426,7 @@ UG_RESULT UG_ButtonSetFont( UG_WINDOW* wnd, UG_U8 id, const UG_FONT* font )
 
    btn = (UG_BUTTON*)(obj->data);
    btn->font = font;
+   btn->layout.valid = 0;
    obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
 
    return UG_RESULT_OK;
@@ -6477,8 +7628,6 @@ void _UG_ButtonUpdate(UG_WINDOW* wnd, UG_OBJECT* obj)
             obj->a_abs.ys = obj->a_rel.ys + a.ys;
             obj->a_abs.xe = obj->a_rel.xe + a.xs;
             obj->a_abs.ye = obj->a_rel.ye + a.ys;
-            if ( obj->a_abs.ye >= wnd->ye ) return;
-            if ( obj->a_abs.xe >= wnd->xe ) return;
 
             /* 3D or 2D style? */
             d = ( btn->style & BTN_STYLE_3D )? 3:1;
@@ -6514,6 +7663,8 @@ void _UG_ButtonUpdate(UG_WINDOW* wnd, UG_OBJECT* obj)
             txt.h_space = 2;
             txt.v_space = 2;
             txt.str = btn->str;
+            txt.transparent = 1;
+            txt.layout = &btn->layout;
             _UG_PutText( &txt );
             obj->state &= ~OBJ_STATE_REDRAW;
          }
@@ -6554,6 +7705,8 @@ UG_RESULT UG_TextboxCreate( UG_WINDOW* wnd, UG_TEXTBOX* txb, UG_U8 id, UG_S16 xs
    txb->align = ALIGN_CENTER;
    txb->h_space = 2;
    txb->v_space = 2;
+   txb->layout.valid = 0;
+   txb->state = 0;
 
    /* Initialize standard object parameters */
    obj->update = _UG_TextboxUpdate;
@@ -6649,7 +7802,8 @@ UG_RESULT UG_TextboxSetText( UG_WINDOW* wnd, UG_U8 id, char* str )
 
    txb = (UG_TEXTBOX*)(obj->data);
    txb->str = str;
-   obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
+   txb->state |= TXB_STATE_TEXT_CHANGED;
+   obj->state |= OBJ_STATE_UPDATE;
 
    return UG_RESULT_OK;
 }
@@ -6664,6 +7818,7 @@ UG_RESULT UG_TextboxSetFont( UG_WINDOW* wnd, UG_U8 id, const UG_FONT* font )
 
    txb = (UG_TEXTBOX*)(obj->data);
    txb->font = font;
+   txb->layout.valid = 0;
    obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
 
    return UG_RESULT_OK;
@@ -6679,6 +7834,7 @@ UG_RESULT UG_TextboxSetHSpace( UG_WINDOW* wnd, UG_U8 id, UG_S8 hs )
 
    txb = (UG_TEXTBOX*)(obj->data);
    txb->h_space = hs;
+   txb->layout.valid = 0;
    obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
 
    return UG_RESULT_OK;
@@ -6694,6 +7850,7 @@ UG_RESULT UG_TextboxSetVSpace( UG_WINDOW* wnd, UG_U8 id, UG_S8 vs )
 
    txb = (UG_TEXTBOX*)(obj->data);
    txb->v_space = vs;
+   txb->layout.valid = 0;
    obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
 
    return UG_RESULT_OK;
@@ -6709,6 +7866,7 @@ UG_RESULT UG_TextboxSetAlignment( UG_WINDOW* wnd, UG_U8 id, UG_U8 align )
 
    txb = (UG_TEXTBOX*)(obj->data);
    txb->align = align;
+   txb->layout.valid = 0;
    obj->state |= OBJ_STATE_UPDATE | OBJ_STATE_REDRAW;
 
    return UG_RESULT_OK;
@@ -6841,6 +7999,12 @@ void _UG_TextboxUpdate(UG_WINDOW* wnd, UG_OBJECT* obj)
    {
       if ( obj->state & OBJ_STATE_VISIBLE )
       {
+         /* Only the text changed? Redraw the characters that differ */
+         if ( !(obj->state & OBJ_STATE_REDRAW) && (txb->state & TXB_STATE_TEXT_CHANGED) )
+         {
+            if ( _UG_TextboxUpdateText(obj, txb) != UG_RESULT_OK ) obj->state |= OBJ_STATE_REDRAW;
+         }
+
          /* Full redraw necessary? */
          if ( obj->state & OBJ_STATE_REDRAW )
          {
@@ -6849,31 +8013,23 @@ void _UG_TextboxUpdate(UG_WINDOW* wnd, UG_OBJECT* obj)
             obj->a_abs.ys = obj->a_rel.ys + a.ys;
             obj->a_abs.xe = obj->a_rel.xe + a.xs;
             obj->a_abs.ye = obj->a_rel.ye + a.ys;
-            if ( obj->a_abs.ye >= wnd->ye ) return;
-            if ( obj->a_abs.xe >= wnd->xe ) return;
-
-            txt.bc = txb->bc;
-            txt.fc = txb->fc;
 
-            UG_FillFrame(obj->a_abs.xs, obj->a_abs.ys, obj->a_abs.xe, obj->a_abs.ye, txt.bc);
+            UG_FillFrame(obj->a_abs.xs, obj->a_abs.ys, obj->a_abs.xe, obj->a_abs.ye, txb->bc);
 
             /* Draw Textbox text */
-            txt.a.xs = obj->a_abs.xs;
-            txt.a.ys = obj->a_abs.ys;
-            txt.a.xe = obj->a_abs.xe;
-            txt.a.ye = obj->a_abs.ye;
-            txt.align = txb->align;
-            txt.font = txb->font;
-            txt.h_space = txb->h_space;
-            txt.v_space = txb->v_space;
-            txt.str = txb->str;
+            if ( txb->state & TXB_STATE_TEXT_CHANGED ) txb->layout.valid = 0;
+            _UG_TextboxGetText(obj, txb, &txt);
+            txt.transparent = 1;
             _UG_PutText( &txt );
+            _UG_TextboxSaveText(txb);
             obj->state &= ~OBJ_STATE_REDRAW;
          }
+         txb->state &= ~TXB_STATE_TEXT_CHANGED;
       }
       else
       {
          UG_FillFrame(obj->a_abs.xs, obj->a_abs.ys, obj->a_abs.xe, obj->a_abs.ye, wnd->bc);
+         txb->state &= ~TXB_STATE_SAVED;
       }
       obj->state &= ~OBJ_STATE_UPDATE;
    }
@@ -6993,8 +8149,6 @@ void _UG_ImageUpdate(UG_WINDOW* wnd, UG_OBJECT* obj)
             obj->a_abs.ys = obj->a_rel.ys + a.ys;
             obj->a_abs.xe = obj->a_rel.xs + ((UG_BMP*)img->img)->width + a.xs;
             obj->a_abs.ye = obj->a_rel.ys + ((UG_BMP*)img->img)->height + a.ys;
-            if ( obj->a_abs.ye >= wnd->ye ) return;
-            if ( obj->a_abs.xe >= wnd->xe ) return;
 
             /* Draw Image */
             if ( (img->img != NULL) && (img->type & IMG_TYPE_BMP) )